@@ -17,12 +17,476 @@
 #include <memory>
 #include <random>
 #include <numeric>
+#include <cmath>
+#include <charconv>
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <limits>
+#include <unistd.h>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <atomic>
+#include <sys/uio.h>
+#include <string_view>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <cerrno>
 
 #define WL_VERSION "Wei- Aurora"
 #define WL_RELEASE_DATE "2026-02-15"
 int WL_YN_INTERSTELLAR = 1;  
 
+const size_t NUMBER_CHARS = 32;
+
+char* formatNumberTo(char* first, char* last, double num) {
+    if (num == 0) {
+        *first = '0';
+        return first + 1;
+    }
+    if (std::fabs(num) < 9007199254740992.0 && num == std::trunc(num)) {
+        return std::to_chars(first, last, static_cast<long long>(num)).ptr;
+    }
+    return std::to_chars(first, last, num).ptr;
+}
+
+std::string formatNumber(double num) {
+    char buf[NUMBER_CHARS];
+    return std::string(buf, formatNumberTo(buf, buf + sizeof(buf), num));
+}
+
+const char* scanNumber(const char* first, const char* last, double& out) {
+    const char* p = first;
+    while (p != last && isspace(static_cast<unsigned char>(*p))) ++p;
+    bool negative = false;
+    if (p != last && (*p == '+' || *p == '-')) {
+        negative = *p == '-';
+        ++p;
+    }
+    if (p != last && *p == '-') return first;
+    std::from_chars_result res;
+    if (last - p > 2 && p[0] == '0' && (p[1] == 'x' || p[1] == 'X')) {
+        res = std::from_chars(p + 2, last, out, std::chars_format::hex);
+    } else {
+        res = std::from_chars(p, last, out);
+    }
+    if (res.ec != std::errc()) return first;
+    if (negative) out = -out;
+    return res.ptr;
+}
+
+bool scanNumber(const std::string& s, double& out) {
+    return scanNumber(s.data(), s.data() + s.size(), out) != s.data();
+}
+
+double textToNumber(const std::string& s) {
+    double v = 0;
+    return scanNumber(s, v) ? v : 0.0;
+}
+
+bool parseNumber(const std::string& s, double& out) {
+    const char* first = s.data();
+    const char* last = first + s.size();
+    if (first != last && *first == '+') ++first;
+    if (first == last) return false;
+    auto res = std::from_chars(first, last, out);
+    return res.ec == std::errc() && res.ptr == last;
+}
+
+size_t utf8Length(const char* p, size_t n) {
+    size_t count = 0;
+    for (size_t i = 0; i < n; ++i) {
+        if ((static_cast<unsigned char>(p[i]) & 0xC0) != 0x80) count++;
+    }
+    return count;
+}
+
+size_t utf8Prefix(const char* p, size_t n, size_t chars) {
+    size_t i = 0;
+    while (i < n) {
+        if ((static_cast<unsigned char>(p[i]) & 0xC0) != 0x80) {
+            if (chars == 0) break;
+            chars--;
+        }
+        i++;
+    }
+    return i;
+}
+
+struct AsyncWriter {
+    static constexpr size_t RING = 1 << 22;
+    static constexpr std::chrono::milliseconds IDLE_WAIT{50};
+
+    std::unique_ptr<char[]> ring{new char[RING]};
+    std::atomic<size_t> head{0};
+    std::atomic<size_t> tail{0};
+    std::atomic<bool> idle{false};
+    std::atomic<bool> stopping{false};
+    std::mutex parking;
+    std::condition_variable wake;
+    std::thread worker;
+
+    AsyncWriter() : worker(&AsyncWriter::run, this) {}
+
+    ~AsyncWriter() {
+        drain();
+        stopping.store(true);
+        notify();
+        worker.join();
+    }
+
+    void push(const char* p, size_t n) {
+        while (n > 0) {
+            size_t h = head.load(std::memory_order_relaxed);
+            size_t space = RING - (h - tail.load(std::memory_order_acquire));
+            if (space == 0) {
+                notify();
+                std::this_thread::yield();
+                continue;
+            }
+            size_t chunk = std::min(n, space);
+            size_t at = h & (RING - 1);
+            size_t first = std::min(chunk, RING - at);
+            memcpy(ring.get() + at, p, first);
+            memcpy(ring.get(), p + first, chunk - first);
+            head.store(h + chunk);
+            p += chunk;
+            n -= chunk;
+            notify();
+        }
+    }
+
+    void drain() {
+        notify();
+        while (tail.load(std::memory_order_acquire) != head.load(std::memory_order_acquire)) {
+            std::this_thread::yield();
+        }
+    }
+
+    void notify() {
+        if (idle.load()) {
+            std::lock_guard<std::mutex> guard(parking);
+            wake.notify_one();
+        }
+    }
+
+    void run() {
+        while (true) {
+            size_t t = tail.load(std::memory_order_relaxed);
+            size_t h = head.load(std::memory_order_acquire);
+            if (h == t) {
+                if (stopping.load()) return;
+                std::unique_lock<std::mutex> guard(parking);
+                idle.store(true);
+                if (head.load() == t && !stopping.load()) wake.wait_for(guard, IDLE_WAIT);
+                idle.store(false);
+                continue;
+            }
+            size_t at = t & (RING - 1);
+            size_t first = std::min(h - t, RING - at);
+            iovec iov[2] = {{ring.get() + at, first}, {ring.get(), h - t - first}};
+            ssize_t w = ::writev(STDOUT_FILENO, iov, iov[1].iov_len > 0 ? 2 : 1);
+            if (w < 0 && errno == EINTR) continue;
+            tail.store(w < 0 ? h : t + static_cast<size_t>(w), std::memory_order_release);
+        }
+    }
+};
+
+struct OutputBuffer {
+    static constexpr size_t CAPACITY = 1 << 16;
+    static constexpr std::chrono::milliseconds FLUSH_INTERVAL{100};
+
+    std::string data;
+    bool lineBuffered;
+    std::chrono::steady_clock::time_point lastFlush;
+    std::unique_ptr<AsyncWriter> async;
+
+    OutputBuffer() : lineBuffered(isatty(STDOUT_FILENO) != 0), lastFlush(std::chrono::steady_clock::now()) {
+        data.reserve(CAPACITY);
+        const char* mode = std::getenv("WL_OUTPUT");
+        if (mode && strcmp(mode, "line") == 0) lineBuffered = true;
+        else if (mode && strcmp(mode, "full") == 0) lineBuffered = false;
+        else if (mode && strcmp(mode, "async") == 0) async = std::make_unique<AsyncWriter>();
+    }
+
+    ~OutputBuffer() {
+        flush();
+    }
+
+    void write(const char* p, size_t n) {
+        if (data.size() + n > CAPACITY) {
+            spill();
+            if (n >= CAPACITY) {
+                emit(p, n);
+                return;
+            }
+        }
+        data.append(p, n);
+    }
+
+    void write(const std::string& s) {
+        write(s.data(), s.size());
+    }
+
+    void writeNumber(double num) {
+        if (data.size() + NUMBER_CHARS > CAPACITY) spill();
+        size_t n = data.size();
+        data.resize(n + NUMBER_CHARS);
+        char* end = formatNumberTo(&data[n], &data[n] + NUMBER_CHARS, num);
+        data.resize(static_cast<size_t>(end - data.data()));
+    }
+
+    void put(char c) {
+        if (data.size() + 1 > CAPACITY) spill();
+        data.push_back(c);
+    }
+
+    void writePadded(const char* p, size_t n, size_t width, bool leftAlign) {
+        size_t length = utf8Length(p, n);
+        size_t pad = width > length ? width - length : 0;
+        if (!leftAlign) fill(' ', pad);
+        write(p, n);
+        if (leftAlign) fill(' ', pad);
+    }
+
+    void fill(char c, size_t n) {
+        if (data.size() + n > CAPACITY) spill();
+        if (n >= CAPACITY) {
+            std::string pad(n, c);
+            emit(pad.data(), pad.size());
+            return;
+        }
+        data.append(n, c);
+    }
+
+    void endLine() {
+        put('\n');
+        if (lineBuffered) {
+            spill();
+        } else {
+            flushIfStale();
+        }
+    }
+
+    void flushIfStale() {
+        if (data.empty()) return;
+        auto now = std::chrono::steady_clock::now();
+        if (now - lastFlush >= FLUSH_INTERVAL) spill();
+    }
+
+    void spill() {
+        if (!data.empty()) {
+            emit(data.data(), data.size());
+            data.clear();
+        }
+        lastFlush = std::chrono::steady_clock::now();
+    }
+
+    void flush() {
+        spill();
+        if (async) async->drain();
+    }
+
+    void emit(const char* p, size_t n) {
+        if (async) async->push(p, n);
+        else writeAll(p, n);
+    }
+
+    static void writeAll(const char* p, size_t n) {
+        while (n > 0) {
+            ssize_t w = ::write(STDOUT_FILENO, p, n);
+            if (w < 0) {
+                if (errno == EINTR) continue;
+                return;
+            }
+            p += w;
+            n -= static_cast<size_t>(w);
+        }
+    }
+};
+
+OutputBuffer& output() {
+    static OutputBuffer buffer;
+    return buffer;
+}
+
+struct InputReader {
+    static constexpr size_t CHUNK = 1 << 20;
+    static constexpr size_t PREFETCH_DEPTH = 4;
+
+    std::vector<char> current;
+    size_t pos = 0;
+    bool eof = false;
+    std::string carry;
+
+    bool prefetch = false;
+    std::mutex lock;
+    std::condition_variable ready;
+    std::condition_variable drained;
+    std::deque<std::vector<char>> filled;
+    std::vector<std::vector<char>> spare;
+    bool producerDone = false;
+
+    InputReader() {
+        const char* mode = std::getenv("WL_INPUT");
+        if (mode && strcmp(mode, "prefetch") == 0 && !isatty(STDIN_FILENO)) {
+            prefetch = true;
+            std::thread(&InputReader::produce, this).detach();
+        }
+    }
+
+    static size_t readChunk(std::vector<char>& chunk) {
+        chunk.resize(CHUNK);
+        ssize_t r;
+        do {
+            r = ::read(STDIN_FILENO, chunk.data(), CHUNK);
+        } while (r < 0 && errno == EINTR);
+        size_t n = r > 0 ? static_cast<size_t>(r) : 0;
+        chunk.resize(n);
+        return n;
+    }
+
+    void produce() {
+        while (true) {
+            std::vector<char> chunk;
+            {
+                std::unique_lock<std::mutex> guard(lock);
+                drained.wait(guard, [this] { return filled.size() < PREFETCH_DEPTH; });
+                if (!spare.empty()) {
+                    chunk = std::move(spare.back());
+                    spare.pop_back();
+                }
+            }
+            size_t n = readChunk(chunk);
+            std::lock_guard<std::mutex> guard(lock);
+            if (n == 0) {
+                producerDone = true;
+                ready.notify_one();
+                return;
+            }
+            filled.push_back(std::move(chunk));
+            ready.notify_one();
+        }
+    }
+
+    bool fill() {
+        if (eof) return false;
+        if (!prefetch) {
+            output().flush();
+            pos = 0;
+            if (readChunk(current) == 0) eof = true;
+            return !eof;
+        }
+        std::unique_lock<std::mutex> guard(lock);
+        if (filled.empty() && !producerDone) {
+            guard.unlock();
+            output().flush();
+            guard.lock();
+            ready.wait(guard, [this] { return !filled.empty() || producerDone; });
+        }
+        if (!current.empty()) spare.push_back(std::move(current));
+        current.clear();
+        pos = 0;
+        if (filled.empty()) {
+            eof = true;
+            return false;
+        }
+        current = std::move(filled.front());
+        filled.pop_front();
+        drained.notify_one();
+        return true;
+    }
+
+    bool nextLine(const char*& p, size_t& n) {
+        if (pos >= current.size() && !fill()) return false;
+        const char* begin = current.data() + pos;
+        size_t avail = current.size() - pos;
+        const char* nl = static_cast<const char*>(memchr(begin, '\n', avail));
+        if (nl) {
+            p = begin;
+            n = static_cast<size_t>(nl - begin);
+            pos += n + 1;
+            return true;
+        }
+        carry.assign(begin, avail);
+        pos = current.size();
+        while (fill()) {
+            begin = current.data();
+            nl = static_cast<const char*>(memchr(begin, '\n', current.size()));
+            if (nl) {
+                carry.append(begin, nl);
+                pos = static_cast<size_t>(nl - begin) + 1;
+                break;
+            }
+            carry.append(begin, current.size());
+            pos = current.size();
+        }
+        p = carry.data();
+        n = carry.size();
+        return true;
+    }
+
+    bool readLine(std::string& line) {
+        const char* p = nullptr;
+        size_t n = 0;
+        if (!nextLine(p, n)) {
+            line.clear();
+            return false;
+        }
+        line.assign(p, n);
+        return true;
+    }
+
+    template <typename Buffer>
+    bool readNumbers(Buffer& out, std::string& bad) {
+        while (true) {
+            while (pos < current.size() && isspace(static_cast<unsigned char>(current[pos]))) pos++;
+            if (pos >= current.size()) {
+                if (!fill()) return true;
+                continue;
+            }
+            const char* first = current.data() + pos;
+            const char* last = current.data() + current.size();
+            const char* end = first;
+            while (end < last && !isspace(static_cast<unsigned char>(*end))) end++;
+            if (end == last && !eof) {
+                carry.assign(first, end);
+                pos = current.size();
+                while (fill()) {
+                    const char* b = current.data();
+                    const char* e = b;
+                    const char* stop = b + current.size();
+                    while (e < stop && !isspace(static_cast<unsigned char>(*e))) e++;
+                    carry.append(b, e);
+                    pos = static_cast<size_t>(e - b);
+                    if (e < stop) break;
+                }
+                first = carry.data();
+                end = first + carry.size();
+            } else {
+                pos += static_cast<size_t>(end - first);
+            }
+            if (first < end && *first == '+') first++;
+            double v = 0;
+            auto res = std::from_chars(first, end, v);
+            if (res.ec != std::errc() || res.ptr != end) {
+                bad.assign(first, end);
+                return false;
+            }
+            out.push_back(v);
+        }
+    }
+};
+
+InputReader& input() {
+    static InputReader* reader = new InputReader();
+    return *reader;
+}
+
 void error(const std::string& file, int line, int col, const std::string& msg) {
+    output().flush();
     std::cerr << "\033[1;31m执行错误 " << file << " 时遇到问题\033[0m" << std::endl;
     std::cerr << "\033[1;31m" << file << ":" << line << ":" << col
               << ": \033[1;35m错误:\033[0m\033[1;31m " << msg << "\033[0m" << std::endl;
@@ -30,12 +494,13 @@ void error(const std::string& file, int line, int col, const std::string& msg) {
 }
 
 void warning(const std::string& file, int line, int col, const std::string& msg) {
+    output().flush();
     std::cerr << "\033[1;33m" << file << ":" << line << ":" << col
               << ": \033[1;36m警告:\033[0m\033[1;33m " << msg << "\033[0m" << std::endl;
 }
 
 enum class TokenType {
-    CREATE_INT, CREATE_DOUBLE, CREATE_OMNI, CREATE_STRING, CREATE_ARR,
+    CREATE_INT, CREATE_DOUBLE, CREATE_OMNI, CREATE_STRING, CREATE_ARR, CREATE_DICT, CREATE_RECORD, CREATE_HEAP,
     OUTPUT_REDIRECT, INPUT_REDIRECT,
     STRING, NUMBER, IDENTIFIER, ASSIGN, CREATE, FUNCTION,
     LPAREN, RPAREN, LBRACE, RBRACE, LBRACKET, RBRACKET,
@@ -53,2390 +518,7308 @@ enum class TokenType {
     TILDE,      
 };
 
+struct OutputTemplate;
+
 struct Token {
     TokenType type;
     std::string lexeme;
     int line;
     int col;
+    mutable size_t cacheKey = 0;
+    mutable size_t cacheSlot = 0;
+    std::shared_ptr<std::shared_ptr<const OutputTemplate>> outputTemplate;
     Token(TokenType t, const std::string& l, int ln, int cl)
-        : type(t), lexeme(l), line(ln), col(cl) {}
+        : type(t), lexeme(l), line(ln), col(cl) {
+        if (t == TokenType::OUTPUT_REDIRECT) outputTemplate = std::make_shared<std::shared_ptr<const OutputTemplate>>();
+    }
+};
+
+struct OutputPiece {
+    enum class Kind { LITERAL, DTIME, VARIABLE, VALUE, EXPR };
+
+    Kind kind;
+    std::string text;
+    size_t begin = 0;
+    size_t end = 0;
+    std::vector<Token> expr;
+    bool formatted = false;
+    bool leftAlign = false;
+    size_t width = 0;
+    int precision = -1;
+
+    explicit OutputPiece(Kind k = Kind::LITERAL) : kind(k) {}
+};
+
+struct OutputTemplate {
+    std::vector<OutputPiece> pieces;
+    size_t length = 0;
+    bool newline = false;
 };
 
 enum class VarType {
-    INT, DOUBLE, OMNI, STRING, ARRAY,
+    INT, DOUBLE, OMNI, STRING, ARRAY, DICT, RECORD, HEAP, INDEX, DIGEST, CSV,
 };
 
-struct Variable {
-    VarType type;
-    std::string value;
-    std::vector<Variable> arrayElements;
-    std::vector<size_t> dims;
-    std::vector<Variable> flatData;
 
-    Variable(VarType t = VarType::DOUBLE, const std::string& v = "0")
-        : type(t), value(v) {}
+const size_t PARALLEL_GRAIN = 1 << 16;
 
-    bool isNumeric() const {
-        return type == VarType::INT || type == VarType::DOUBLE || type == VarType::OMNI;
+size_t workerCount() {
+    static const size_t n = std::max<unsigned>(1, std::thread::hardware_concurrency());
+    return n;
+}
+
+size_t chunkCount(size_t n) {
+    if (n < 2 * PARALLEL_GRAIN) return 1;
+    return std::max<size_t>(1, std::min(workerCount(), n / PARALLEL_GRAIN));
+}
+
+
+template <typename F>
+void parallelChunks(size_t n, size_t chunks, F&& body) {
+    if (chunks <= 1) {
+        body(0, 0, n);
+        return;
     }
- 
-    bool isArray() const {
-        return type == VarType::ARRAY;
+    size_t step = (n + chunks - 1) / chunks;
+    std::vector<std::thread> pool;
+    pool.reserve(chunks - 1);
+    for (size_t c = 1; c < chunks; ++c) {
+        size_t b = std::min(n, c * step);
+        size_t e = std::min(n, b + step);
+        pool.emplace_back([&body, c, b, e] { body(c, b, e); });
     }
+    body(0, 0, std::min(n, step));
+    for (auto& t : pool) t.join();
+}
 
-    double getNumericValue() const {
-        try {
-            return std::stod(value);
-        } catch (...) {
-            return 0.0;
-        }
-    }
 
-    void setDims(const std::vector<size_t>& dimensions) {
-        dims = dimensions;
-        size_t total = 1;
-        for (size_t d : dims) total *= d;
-        flatData.resize(total, Variable(VarType::OMNI, "0"));
-        if (total > 0) value = flatData[0].value;
-        arrayElements.clear();
-    }
+enum class SumMode { FAST, KAHAN, PAIRWISE };
 
-    size_t flattenIndex(const std::vector<size_t>& indices) const {
-        if (indices.size() != dims.size()) {
-            throw std::runtime_error("维度不匹配");
-        }
-        size_t idx = 0, mul = 1;
-        for (int i = dims.size() - 1; i >= 0; i--) {
-            if (indices[i] >= dims[i]) {
-                throw std::runtime_error("索引越界");
-            }
-            idx += indices[i] * mul;
-            mul *= dims[i];
-        }
-        return idx;
+double sumBlock(const double* p, size_t n) {
+    double acc[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        for (int k = 0; k < 8; ++k) acc[k] += p[i + k];
     }
+    double s = ((acc[0] + acc[1]) + (acc[2] + acc[3])) + ((acc[4] + acc[5]) + (acc[6] + acc[7]));
+    for (; i < n; ++i) s += p[i];
+    return s;
+}
 
-    Variable& getElement(const std::vector<size_t>& indices) {
-        return flatData[flattenIndex(indices)];
-    }
+double pairwiseBlock(const double* p, size_t n) {
+    if (n <= 256) return sumBlock(p, n);
+    size_t half = (n / 2) & ~static_cast<size_t>(7);
+    return pairwiseBlock(p, half) + pairwiseBlock(p + half, n - half);
+}
 
-    const Variable& getElement(const std::vector<size_t>& indices) const {
-        return flatData[flattenIndex(indices)];
-    }
+void neumaierAdd(double& s, double& c, double x) {
+    double t = s + x;
+    if (std::fabs(s) >= std::fabs(x)) c += (s - t) + x;
+    else c += (x - t) + s;
+    s = t;
+}
 
-    Variable& getArrayElement(size_t index) {
-        if (!dims.empty()) {
-            return getElement({index});
+double kahanBlock(const double* p, size_t n) {
+    double acc[4] = {0, 0, 0, 0};
+    double comp[4] = {0, 0, 0, 0};
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        for (int k = 0; k < 4; ++k) {
+            double y = p[i + k] - comp[k];
+            double t = acc[k] + y;
+            comp[k] = (t - acc[k]) - y;
+            acc[k] = t;
         }
-        return arrayElements[index];
     }
+    double s = 0, c = 0;
+    for (int k = 0; k < 4; ++k) {
+        neumaierAdd(s, c, acc[k]);
+        c -= comp[k];
+    }
+    for (; i < n; ++i) neumaierAdd(s, c, p[i]);
+    return s + c;
+}
 
-    
-    size_t getArraySize() const {
-        if (!dims.empty()) {
-            return dims[0];
+double reduceSum(const double* p, size_t n, SumMode mode = SumMode::FAST) {
+    size_t chunks = chunkCount(n);
+    std::vector<double> partial(chunks, 0.0);
+    parallelChunks(n, chunks, [&](size_t c, size_t b, size_t e) {
+        if (mode == SumMode::KAHAN) partial[c] = kahanBlock(p + b, e - b);
+        else if (mode == SumMode::PAIRWISE) partial[c] = pairwiseBlock(p + b, e - b);
+        else partial[c] = sumBlock(p + b, e - b);
+    });
+    if (mode == SumMode::FAST) return sumBlock(partial.data(), partial.size());
+    double s = 0, c = 0;
+    for (double v : partial) neumaierAdd(s, c, v);
+    return s + c;
+}
+
+double reduceProd(const double* p, size_t n) {
+    size_t chunks = chunkCount(n);
+    std::vector<double> partial(chunks, 1.0);
+    parallelChunks(n, chunks, [&](size_t c, size_t b, size_t e) {
+        double acc[8] = {1, 1, 1, 1, 1, 1, 1, 1};
+        size_t i = b;
+        for (; i + 8 <= e; i += 8) {
+            for (int k = 0; k < 8; ++k) acc[k] *= p[i + k];
         }
-        return arrayElements.size();
-    }
+        double r = ((acc[0] * acc[1]) * (acc[2] * acc[3])) * ((acc[4] * acc[5]) * (acc[6] * acc[7]));
+        for (; i < e; ++i) r *= p[i];
+        partial[c] = r;
+    });
+    double r = 1.0;
+    for (double v : partial) r *= v;
+    return r;
+}
 
-    
-    std::string arrayToString() const {
-        if (!dims.empty()) {
-            size_t flatIdx = 0;
-            return multidimensionalToString(0, flatIdx);
+double reduceDot(const double* a, const double* b, size_t n) {
+    size_t chunks = chunkCount(n);
+    std::vector<double> partial(chunks, 0.0);
+    parallelChunks(n, chunks, [&](size_t c, size_t lo, size_t hi) {
+        double acc[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+        size_t i = lo;
+        for (; i + 8 <= hi; i += 8) {
+            for (int k = 0; k < 8; ++k) acc[k] += a[i + k] * b[i + k];
         }
-        if (arrayElements.empty()) return "[]";
-        std::string r = "[";
-        for (size_t i = 0; i < arrayElements.size(); ++i) {
-            if (i > 0) r += ", ";
-            r += arrayElements[i].value;
+        double s = ((acc[0] + acc[1]) + (acc[2] + acc[3])) + ((acc[4] + acc[5]) + (acc[6] + acc[7]));
+        for (; i < hi; ++i) s += a[i] * b[i];
+        partial[c] = s;
+    });
+    return sumBlock(partial.data(), partial.size());
+}
+
+template <bool IsMax>
+double extremeBlock(const double* p, size_t n) {
+    double acc[8];
+    for (int k = 0; k < 8; ++k) acc[k] = p[0];
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        for (int k = 0; k < 8; ++k) {
+            double v = p[i + k];
+            acc[k] = IsMax ? (v > acc[k] ? v : acc[k]) : (v < acc[k] ? v : acc[k]);
         }
-        r += "]";
-        return r;
     }
+    double r = acc[0];
+    for (int k = 1; k < 8; ++k) r = IsMax ? std::max(r, acc[k]) : std::min(r, acc[k]);
+    for (; i < n; ++i) r = IsMax ? std::max(r, p[i]) : std::min(r, p[i]);
+    return r;
+}
 
+template <bool IsMax>
+double reduceExtreme(const double* p, size_t n) {
+    size_t chunks = chunkCount(n);
+    std::vector<double> partial(chunks, p[0]);
+    parallelChunks(n, chunks, [&](size_t c, size_t b, size_t e) {
+        if (e > b) partial[c] = extremeBlock<IsMax>(p + b, e - b);
+    });
+    return extremeBlock<IsMax>(partial.data(), partial.size());
+}
 
-    
-    void sort() {
-        if (!isArray()) {
-            throw std::runtime_error("sort()只能用于数组");
-        }
-        if (flatData.empty()) return;
-        
-        for (const auto& elem : flatData) {
-            if (!elem.isNumeric()) {
-                throw std::runtime_error("sort()只能用于数值数组");
+template <bool IsMax>
+size_t reduceArgExtreme(const double* p, size_t n) {
+    double target = reduceExtreme<IsMax>(p, n);
+    size_t chunks = chunkCount(n);
+    std::vector<size_t> found(chunks, n);
+    parallelChunks(n, chunks, [&](size_t c, size_t b, size_t e) {
+        for (size_t i = b; i < e; ++i) {
+            if (p[i] == target) {
+                found[c] = i;
+                break;
             }
         }
-        std::sort(flatData.begin(), flatData.end(), 
-                  [](const Variable& a, const Variable& b) {
-                      return a.getNumericValue() < b.getNumericValue();
-                  });
+    });
+    for (size_t idx : found) {
+        if (idx < n) return idx;
     }
+    return 0;
+}
 
-    
-    double sum() const {
-        if (!isArray()) {
-            throw std::runtime_error("sum()只能用于数组");
+void prefixSum(const double* p, double* out, size_t n) {
+    size_t chunks = chunkCount(n);
+    if (chunks <= 1) {
+        double s = 0;
+        for (size_t i = 0; i < n; ++i) {
+            s += p[i];
+            out[i] = s;
         }
-        if (flatData.empty()) return 0.0;
-        return std::accumulate(flatData.begin(), flatData.end(), 0.0,
-            [](double acc, const Variable& v) { 
-                return acc + v.getNumericValue(); 
-            });
+        return;
     }
-
-    
-    int find(const std::string& substr) const {
-        if (type != VarType::STRING) {
-            throw std::runtime_error("find()只能用于字符串");
-        }
-        size_t pos = value.find(substr);
-        return (pos == std::string::npos) ? -1 : static_cast<int>(pos);
+    std::vector<double> offset(chunks, 0.0);
+    parallelChunks(n, chunks, [&](size_t c, size_t b, size_t e) {
+        offset[c] = sumBlock(p + b, e - b);
+    });
+    double running = 0;
+    for (size_t c = 0; c < chunks; ++c) {
+        double chunkTotal = offset[c];
+        offset[c] = running;
+        running += chunkTotal;
     }
-private:
-    
-    std::string multidimensionalToString(size_t dimIdx, size_t& flatIdx) const {
-        if (dimIdx == dims.size() - 1) {
-            std::string r = "[";
-            for (size_t i = 0; i < dims[dimIdx]; ++i) {
-                if (i > 0) r += ", ";
-                r += flatData[flatIdx++].value;
-            }
-            r += "]";
-            return r;
-        }
-        std::string r = "[";
-        for (size_t i = 0; i < dims[dimIdx]; ++i) {
-            if (i > 0) r += ", ";
-            r += multidimensionalToString(dimIdx + 1, flatIdx);
+    parallelChunks(n, chunks, [&](size_t c, size_t b, size_t e) {
+        double s = offset[c];
+        for (size_t i = b; i < e; ++i) {
+            s += p[i];
+            out[i] = s;
         }
-        r += "]";
-        return r;
-    }
-};
-
+    });
+}
 
-struct Function {
-    std::string name;
-    std::vector<Token> body;
-    std::vector<std::string> paramNames;
-    bool hasReturnValue;
 
-    Function(const std::string& n = "", const std::vector<Token>& b = {}, 
-             bool ret = false) 
-        : name(n), body(b), hasReturnValue(ret) {}
+struct SortOptions {
+    bool descending = false;
+    bool stable = false;
 };
 
+bool integralKeys(const double* p, size_t n) {
+    const double limit = 9007199254740992.0;
+    for (size_t i = 0; i < n; ++i) {
+        double v = p[i];
+        if (!(v >= -limit && v <= limit) || v != std::floor(v)) return false;
+    }
+    return true;
+}
 
-struct TimerState {
-    std::chrono::high_resolution_clock::time_point startTime;
-    bool isRunning;
-    double lastElapsedMs;
+void radixSortIntegers(double* p, size_t n, bool descending) {
+    std::vector<uint64_t> keys(n), tmp(n);
+    for (size_t i = 0; i < n; ++i) {
+        uint64_t k = static_cast<uint64_t>(static_cast<int64_t>(p[i])) ^ (uint64_t(1) << 63);
+        keys[i] = descending ? ~k : k;
+    }
+    for (int shift = 0; shift < 64; shift += 8) {
+        size_t count[256] = {0};
+        for (size_t i = 0; i < n; ++i) count[(keys[i] >> shift) & 0xFF]++;
+        if (count[(keys[0] >> shift) & 0xFF] == n) continue;
+        size_t offset = 0;
+        for (size_t b = 0; b < 256; ++b) {
+            size_t c = count[b];
+            count[b] = offset;
+            offset += c;
+        }
+        for (size_t i = 0; i < n; ++i) tmp[count[(keys[i] >> shift) & 0xFF]++] = keys[i];
+        keys.swap(tmp);
+    }
+    for (size_t i = 0; i < n; ++i) {
+        uint64_t k = descending ? ~keys[i] : keys[i];
+        p[i] = static_cast<double>(static_cast<int64_t>(k ^ (uint64_t(1) << 63)));
+    }
+}
 
-    TimerState() : isRunning(false), lastElapsedMs(0.0) {}
-};
+template <typename Cmp>
+void mergeSortDoubles(double* p, size_t n, const SortOptions& opt, Cmp cmp, bool parallel) {
+    size_t chunks = parallel ? chunkCount(n) : 1;
+    std::vector<size_t> bounds(chunks + 1, n);
+    size_t step = (n + chunks - 1) / std::max<size_t>(chunks, 1);
+    for (size_t c = 0; c < chunks; ++c) bounds[c] = std::min(n, c * step);
+    parallelChunks(n, chunks, [&](size_t, size_t b, size_t e) {
+        if (opt.stable) std::stable_sort(p + b, p + e, cmp);
+        else std::sort(p + b, p + e, cmp);
+    });
+    if (chunks <= 1) return;
+
+    std::vector<double> buffer(n);
+    double* src = p;
+    double* dst = buffer.data();
+    while (bounds.size() > 2) {
+        size_t runs = bounds.size() - 1;
+        size_t pairs = (runs + 1) / 2;
+        std::vector<std::thread> pool;
+        for (size_t k = 0; k < pairs; ++k) {
+            size_t lo = bounds[2 * k];
+            size_t mid = bounds[std::min(2 * k + 1, runs)];
+            size_t hi = bounds[std::min(2 * k + 2, runs)];
+            pool.emplace_back([=] {
+                std::merge(src + lo, src + mid, src + mid, src + hi, dst + lo, cmp);
+            });
+        }
+        for (auto& t : pool) t.join();
+        std::vector<size_t> next;
+        for (size_t k = 0; k < bounds.size(); k += 2) next.push_back(bounds[k]);
+        if (next.back() != n) next.push_back(n);
+        bounds.swap(next);
+        std::swap(src, dst);
+    }
+    if (src != p) std::copy(src, src + n, p);
+}
 
+void sortDoubles(double* p, size_t n, const SortOptions& opt, bool parallel = true) {
+    double* finite = std::stable_partition(p, p + n, [](double v) { return !std::isnan(v); });
+    size_t m = static_cast<size_t>(finite - p);
+    if (m < 2) return;
+    if (m >= 256 && integralKeys(p, m)) {
+        radixSortIntegers(p, m, opt.descending);
+    } else if (opt.descending) {
+        mergeSortDoubles(p, m, opt, std::greater<double>(), parallel);
+    } else {
+        mergeSortDoubles(p, m, opt, std::less<double>(), parallel);
+    }
+}
 
-struct Scanner {
-    std::string src;
-    std::string filename;
-    size_t pos = 0;
-    int line = 1;
-    int col = 1;
-    bool in_output_redirect = false;
-    bool in_create = false;
+int charAt(const std::string* s, size_t depth) {
+    return depth < s->size() ? static_cast<unsigned char>((*s)[depth]) : -1;
+}
 
-    Scanner(const std::string& s, const std::string& fname)
-        : src(s), filename(fname) {}
+void multikeySort(const std::string** a, size_t n, size_t depth) {
+    while (n > 1) {
+        if (n < 16) {
+            for (size_t i = 1; i < n; ++i) {
+                for (size_t j = i; j > 0 &&
+                     a[j]->compare(std::min(depth, a[j]->size()), std::string::npos,
+                                   *a[j-1], std::min(depth, a[j-1]->size()), std::string::npos) < 0; --j) {
+                    std::swap(a[j], a[j-1]);
+                }
+            }
+            return;
+        }
+        int x = charAt(a[0], depth), y = charAt(a[n / 2], depth), z = charAt(a[n - 1], depth);
+        int pivot = std::max(std::min(x, y), std::min(std::max(x, y), z));
+        size_t lt = 0, i = 0, gt = n;
+        while (i < gt) {
+            int c = charAt(a[i], depth);
+            if (c < pivot) std::swap(a[lt++], a[i++]);
+            else if (c > pivot) std::swap(a[i], a[--gt]);
+            else i++;
+        }
+        multikeySort(a, lt, depth);
+        if (pivot >= 0) multikeySort(a + lt, gt - lt, depth + 1);
+        a += gt;
+        n -= gt;
+    }
+}
 
-    
-    bool match(const std::string& s) {
-        if (pos + s.length() > src.length()) return false;
-        return src.substr(pos, s.length()) == s;
+void sortStrings(std::string* p, size_t n, bool descending) {
+    std::vector<const std::string*> order(n);
+    for (size_t i = 0; i < n; ++i) order[i] = p + i;
+    multikeySort(order.data(), n, 0);
+    if (descending) std::reverse(order.begin(), order.end());
+    std::vector<std::string> sorted;
+    sorted.reserve(n);
+    for (const std::string* s : order) sorted.push_back(std::move(*const_cast<std::string*>(s)));
+    std::move(sorted.begin(), sorted.end(), p);
+}
+
+
+const size_t GEMM_MR = 4;
+const size_t GEMM_NR = 8;
+const size_t GEMM_MC = 64;
+const size_t GEMM_KC = 256;
+const size_t GEMM_NC = 512;
+
+template <size_t Rows>
+void gemmMicroKernel(const double* a, size_t lda, const double* panel, size_t kc,
+                     double* c, size_t ldc, size_t cols) {
+    double acc[Rows][GEMM_NR];
+    for (size_t r = 0; r < Rows; ++r) {
+        for (size_t j = 0; j < GEMM_NR; ++j) acc[r][j] = 0.0;
+    }
+    for (size_t p = 0; p < kc; ++p) {
+        const double* b = panel + p * GEMM_NR;
+        for (size_t r = 0; r < Rows; ++r) {
+            double av = a[r * lda + p];
+            for (size_t j = 0; j < GEMM_NR; ++j) acc[r][j] += av * b[j];
+        }
     }
+    for (size_t r = 0; r < Rows; ++r) {
+        for (size_t j = 0; j < cols; ++j) c[r * ldc + j] += acc[r][j];
+    }
+}
 
-    
-    void advance() {
-        if (pos < src.size()) {
-            if (src[pos] == '\n') {
-                line++;
-                col = 1;
-            } else {
-                col++;
+void matmulKernel(const double* a, const double* b, double* c, size_t m, size_t k, size_t n) {
+    std::fill(c, c + m * n, 0.0);
+    if (m == 0 || n == 0 || k == 0) return;
+    std::vector<double> packed;
+    for (size_t jc = 0; jc < n; jc += GEMM_NC) {
+        size_t nc = std::min(GEMM_NC, n - jc);
+        size_t panels = (nc + GEMM_NR - 1) / GEMM_NR;
+        for (size_t pc = 0; pc < k; pc += GEMM_KC) {
+            size_t kc = std::min(GEMM_KC, k - pc);
+            packed.assign(panels * kc * GEMM_NR, 0.0);
+            for (size_t jp = 0; jp < panels; ++jp) {
+                size_t j0 = jc + jp * GEMM_NR;
+                size_t cols = std::min(GEMM_NR, n - j0);
+                double* dst = packed.data() + jp * kc * GEMM_NR;
+                for (size_t p = 0; p < kc; ++p) {
+                    const double* src = b + (pc + p) * n + j0;
+                    for (size_t j = 0; j < cols; ++j) dst[p * GEMM_NR + j] = src[j];
+                }
             }
-            pos++;
+            size_t rowBlocks = (m + GEMM_MC - 1) / GEMM_MC;
+            size_t chunks = std::min(rowBlocks, chunkCount(m * nc * kc / 64));
+            parallelChunks(rowBlocks, chunks, [&](size_t, size_t blo, size_t bhi) {
+                for (size_t ib = blo; ib < bhi; ++ib) {
+                    size_t i0 = ib * GEMM_MC;
+                    size_t mc = std::min(GEMM_MC, m - i0);
+                    for (size_t jp = 0; jp < panels; ++jp) {
+                        size_t j0 = jc + jp * GEMM_NR;
+                        size_t cols = std::min(GEMM_NR, n - j0);
+                        const double* panel = packed.data() + jp * kc * GEMM_NR;
+                        size_t ir = 0;
+                        for (; ir + GEMM_MR <= mc; ir += GEMM_MR) {
+                            gemmMicroKernel<GEMM_MR>(a + (i0 + ir) * k + pc, k, panel, kc,
+                                                     c + (i0 + ir) * n + j0, n, cols);
+                        }
+                        for (; ir < mc; ++ir) {
+                            gemmMicroKernel<1>(a + (i0 + ir) * k + pc, k, panel, kc,
+                                               c + (i0 + ir) * n + j0, n, cols);
+                        }
+                    }
+                }
+            });
         }
     }
+}
 
-    
-    void skipWhitespace() {
-        while (pos < src.size()) {
-            char c = src[pos];
-            if (c == ' ' || c == '\t' || c == '\r') {
-                col++;
-                pos++;
-            } else if (c == '\n') {
-                line++;
-                col = 1;
-                pos++;
-            } else {
-                break;
+void transposeKernel(const double* src, double* dst, size_t rows, size_t cols) {
+    const size_t tile = 32;
+    size_t tileRows = (rows + tile - 1) / tile;
+    parallelChunks(tileRows, std::min(tileRows, chunkCount(rows * cols)), [&](size_t, size_t lo, size_t hi) {
+        for (size_t ti = lo; ti < hi; ++ti) {
+            size_t i0 = ti * tile, i1 = std::min(rows, i0 + tile);
+            for (size_t j0 = 0; j0 < cols; j0 += tile) {
+                size_t j1 = std::min(cols, j0 + tile);
+                for (size_t i = i0; i < i1; ++i) {
+                    for (size_t j = j0; j < j1; ++j) dst[j * rows + i] = src[i * cols + j];
+                }
+            }
+        }
+    });
+}
+
+void matvecKernel(const double* a, const double* x, double* y, size_t m, size_t n) {
+    parallelChunks(m, std::min(m, chunkCount(m * n)), [&](size_t, size_t lo, size_t hi) {
+        for (size_t i = lo; i < hi; ++i) {
+            const double* row = a + i * n;
+            double acc[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+            size_t j = 0;
+            for (; j + 8 <= n; j += 8) {
+                for (int t = 0; t < 8; ++t) acc[t] += row[j + t] * x[j + t];
             }
+            double s = ((acc[0] + acc[1]) + (acc[2] + acc[3])) + ((acc[4] + acc[5]) + (acc[6] + acc[7]));
+            for (; j < n; ++j) s += row[j] * x[j];
+            y[i] = s;
         }
+    });
+}
+
+void outerKernel(const double* x, const double* y, double* out, size_t m, size_t n) {
+    parallelChunks(m, std::min(m, chunkCount(m * n)), [&](size_t, size_t lo, size_t hi) {
+        for (size_t i = lo; i < hi; ++i) {
+            double xi = x[i];
+            double* row = out + i * n;
+            for (size_t j = 0; j < n; ++j) row[j] = xi * y[j];
+        }
+    });
+}
+
+void rollingSumKernel(const double* p, size_t n, size_t w, double* out) {
+    double sum = 0.0, comp = 0.0;
+    auto add = [&](double v) {
+        double t = sum + v;
+        if (std::abs(sum) >= std::abs(v)) comp += (sum - t) + v;
+        else comp += (v - t) + sum;
+        sum = t;
+    };
+    for (size_t i = 0; i < w; ++i) add(p[i]);
+    out[0] = sum + comp;
+    for (size_t i = w; i < n; ++i) {
+        add(p[i]);
+        add(-p[i - w]);
+        out[i - w + 1] = sum + comp;
     }
+}
 
-    
-    std::vector<Token> scan() {
-        std::vector<Token> tokens;
-        in_output_redirect = false;
-        in_create = false;
+template <bool IsMax>
+void rollingExtremeKernel(const double* p, size_t n, size_t w, double* out) {
+    std::vector<size_t> ring(w);
+    size_t head = 0, count = 0;
+    for (size_t i = 0; i < n; ++i) {
+        double v = p[i];
+        if (count > 0 && ring[head] + w <= i) {
+            head = (head + 1) % w;
+            count--;
+        }
+        while (count > 0) {
+            double back = p[ring[(head + count - 1) % w]];
+            if (IsMax ? back > v : back < v) break;
+            count--;
+        }
+        ring[(head + count) % w] = i;
+        count++;
+        if (i + 1 >= w) out[i + 1 - w] = p[ring[head]];
+    }
+}
 
-        while (pos < src.size()) {
-            skipWhitespace();
-            if (pos >= src.size()) break;
+void ewmaKernel(const double* p, size_t n, double alpha, double* out) {
+    if (n == 0) return;
+    double y = p[0];
+    out[0] = y;
+    for (size_t i = 1; i < n; ++i) {
+        y += alpha * (p[i] - y);
+        out[i] = y;
+    }
+}
 
-            char c = src[pos];
+void diffKernel(const double* p, size_t n, size_t lag, double* out) {
+    for (size_t i = 0; i + lag < n; ++i) out[i] = p[i + lag] - p[i];
+}
 
-            if (match("dtime_tic")) {
-                tokens.emplace_back(TokenType::DTIME_TIC, "dtime_tic", line, col);
-                pos += 9;
-                col += 9;
-                continue;
-            }
+void selectRanks(double* first, size_t n, const size_t* ranks, size_t k, size_t base) {
+    if (k == 0 || n == 0) return;
+    size_t mid = k / 2;
+    size_t r = ranks[mid] - base;
+    std::nth_element(first, first + r, first + n);
+    selectRanks(first, r, ranks, mid, base);
+    selectRanks(first + r + 1, n - r - 1, ranks + mid + 1, k - mid - 1, base + r + 1);
+}
 
-            if (match("dtime_toc")) {
-                tokens.emplace_back(TokenType::DTIME_TOC, "dtime_toc", line, col);
-                pos += 9;
-                col += 9;
-                continue;
-            }
+bool quantileKernel(const double* p, size_t n, const double* qs, size_t m, double* out) {
+    std::vector<double> v;
+    v.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        if (!std::isnan(p[i])) v.push_back(p[i]);
+    }
+    if (v.empty()) return false;
+    size_t last = v.size() - 1;
+    std::vector<size_t> ranks;
+    for (size_t j = 0; j < m; ++j) {
+        size_t lo = static_cast<size_t>(std::floor(qs[j] * last));
+        ranks.push_back(lo);
+        ranks.push_back(std::min(lo + 1, last));
+    }
+    std::sort(ranks.begin(), ranks.end());
+    ranks.erase(std::unique(ranks.begin(), ranks.end()), ranks.end());
+    selectRanks(v.data(), v.size(), ranks.data(), ranks.size(), 0);
+    for (size_t j = 0; j < m; ++j) {
+        double h = qs[j] * last;
+        size_t lo = static_cast<size_t>(std::floor(h));
+        size_t hi = std::min(lo + 1, last);
+        out[j] = v[lo] + (h - lo) * (v[hi] - v[lo]);
+    }
+    return true;
+}
 
-            if (match("dtime()")) {
-                tokens.emplace_back(TokenType::DTIME_FUNC, "dtime()", line, col);
-                pos += 7;
-                col += 7;
-                continue;
-            }
+struct TDigest {
+    double compression = 100.0;
+    double total = 0.0;
+    double min = std::numeric_limits<double>::infinity();
+    double max = -std::numeric_limits<double>::infinity();
+    std::vector<std::pair<double, double>> centroids;
+    std::vector<double> buffer;
+
+    void add(double x) {
+        if (std::isnan(x)) return;
+        buffer.push_back(x);
+        if (buffer.size() >= static_cast<size_t>(compression * 8)) compress();
+    }
 
-            
-            if (match("random")) {
-                tokens.emplace_back(TokenType::RANDOM, "random", line, col);
-                pos += 6;
-                col += 6;
-                continue;
-            }
+    double count() const {
+        return total + buffer.size();
+    }
 
-            if (c == '!') {
-                advance();
-                if (match("utilize")) {
-                    tokens.emplace_back(TokenType::UTILIZE, "!utilize", line, col - 1);
-                    pos += 7;
-                    col += 7;
-                } else {
-                    tokens.emplace_back(TokenType::EXCLAMATION, "!", line, col - 1);
-                }
-                continue;
+    void compress() {
+        if (buffer.empty()) return;
+        std::vector<std::pair<double, double>> all;
+        all.reserve(centroids.size() + buffer.size());
+        all.insert(all.end(), centroids.begin(), centroids.end());
+        for (double x : buffer) {
+            all.emplace_back(x, 1.0);
+            if (x < min) min = x;
+            if (x > max) max = x;
+        }
+        total += buffer.size();
+        buffer.clear();
+        std::sort(all.begin(), all.end());
+        centroids.clear();
+        double soFar = 0.0;
+        std::pair<double, double> cur = all[0];
+        for (size_t i = 1; i < all.size(); ++i) {
+            double proposed = cur.second + all[i].second;
+            double q = (soFar + proposed / 2) / total;
+            if (proposed <= 4 * total * q * (1 - q) / compression) {
+                cur.first += (all[i].first - cur.first) * all[i].second / proposed;
+                cur.second = proposed;
+            } else {
+                soFar += cur.second;
+                centroids.push_back(cur);
+                cur = all[i];
             }
+        }
+        centroids.push_back(cur);
+    }
 
-            if (c == '"') {
-                advance();
-                size_t start = pos;
-                while (pos < src.size() && src[pos] != '"') {
-                    if (src[pos] == '\n') {
-                        error(filename, line, col, "字符串字面量未闭合");
-                    }
-                    advance();
-                }
-                if (pos >= src.size()) {
-                    error(filename, line, col, "未找到闭合的字符串字面量");
-                }
-                std::string s = src.substr(start, pos - start);
-                advance();
-                tokens.emplace_back(TokenType::STRING, s, line, col - (pos - start) - 1);
-                continue;
+    double quantile(double q) {
+        compress();
+        if (centroids.size() == 1) return centroids[0].first;
+        double index = q * total;
+        double firstCenter = centroids[0].second / 2;
+        if (index <= firstCenter) {
+            return min + (centroids[0].first - min) * (firstCenter > 0 ? index / firstCenter : 0.0);
+        }
+        double before = 0.0;
+        for (size_t i = 0; i + 1 < centroids.size(); ++i) {
+            double left = before + centroids[i].second / 2;
+            double right = before + centroids[i].second + centroids[i + 1].second / 2;
+            if (index < right) {
+                double t = (index - left) / (right - left);
+                return centroids[i].first + t * (centroids[i + 1].first - centroids[i].first);
             }
+            before += centroids[i].second;
+        }
+        double lastCenter = total - centroids.back().second / 2;
+        double tail = total - lastCenter;
+        return centroids.back().first +
+               (max - centroids.back().first) * (tail > 0 ? (index - lastCenter) / tail : 0.0);
+    }
+};
 
-            if (match("accept")) {
-                tokens.emplace_back(TokenType::ACCEPT, "accept", line, col);
-                pos += 6;
-                col += 6;
-                while (pos < src.size() && isspace(src[pos])) {
-                    advance();
-                }
-                if (pos < src.size() && src[pos] == '>') {
-                    advance();
-                }
-                continue;
-            }
+struct GroupAcc {
+    size_t count = 0;
+    double sum = 0.0;
+    double min = std::numeric_limits<double>::infinity();
+    double max = -std::numeric_limits<double>::infinity();
+
+    void add(double v) {
+        count++;
+        sum += v;
+        if (v < min) min = v;
+        if (v > max) max = v;
+    }
 
-            if (match("create")) {
-                pos += 6;
-                col += 6;
-                if (pos < src.size() && src[pos] == '.') {
-                    advance();
-                    if (match("int")) {
-                        tokens.emplace_back(TokenType::CREATE_INT, "create.int", line, col - 7);
-                        pos += 3;
-                        col += 3;
-                        in_create = true;
-                        continue;
-                    }
-                    if (match("double")) {
-                        tokens.emplace_back(TokenType::CREATE_DOUBLE, "create.double", line, col - 7);
-                        pos += 6;
-                        col += 6;
-                        in_create = true;
-                        continue;
-                    }
-                    if (match("omni")) {
-                        tokens.emplace_back(TokenType::CREATE_OMNI, "create.omni", line, col - 7);
-                        pos += 4;
-                        col += 4;
-                        in_create = true;
-                        continue;
-                    }
-                    if (match("string")) {
-                        tokens.emplace_back(TokenType::CREATE_STRING, "create.string", line, col - 7);
-                        pos += 6;
-                        col += 6;
-                        in_create = true;
-                        continue;
-                    }
-                    if (match("arr")) {
-                        tokens.emplace_back(TokenType::CREATE_ARR, "create.arr", line, col - 7);
-                        pos += 3;
-                        col += 3;
-                        in_create = true;
-                        continue;
+    void merge(const GroupAcc& other) {
+        count += other.count;
+        sum += other.sum;
+        if (other.min < min) min = other.min;
+        if (other.max > max) max = other.max;
+    }
+};
 
-                    if (match("sort")) {
-                        tokens.emplace_back(TokenType::CREATE_SORT, "create.sort", line, col - 7);
-                        pos += 4;
-                        col += 4;
-                        in_create = true;
-                        continue;
-                    }
-                    if (match("sum")) {
-                        tokens.emplace_back(TokenType::CREATE_SUM, "create.sum", line, col - 7);
-                        pos += 3;
-                        col += 3;
-                        in_create = true;
-                        continue;
-                    }
-                    if (match("sqrt")) {
-                        tokens.emplace_back(TokenType::CREATE_SQRT, "create.sqrt", line, col - 7);
-                        pos += 4;
-                        col += 4;
-                        in_create = true;
-                        continue;
-                    }
+template <typename Key, typename KeyAt>
+std::unordered_map<Key, GroupAcc> groupKernel(size_t n, KeyAt keyAt, const double* values) {
+    size_t chunks = chunkCount(n);
+    std::vector<std::unordered_map<Key, GroupAcc>> partial(chunks);
+    parallelChunks(n, chunks, [&](size_t c, size_t b, size_t e) {
+        std::unordered_map<Key, GroupAcc>& local = partial[c];
+        Key k;
+        for (size_t i = b; i < e; ++i) {
+            if (!keyAt(i, k)) continue;
+            local[k].add(values ? values[i] : 1.0);
+        }
+    });
+    for (size_t c = 1; c < chunks; ++c) {
+        for (const auto& kv : partial[c]) partial[0][kv.first].merge(kv.second);
+    }
+    return std::move(partial[0]);
+}
 
-                    }
-                }
-                tokens.emplace_back(TokenType::CREATE, "create", line, col - 6);
-                continue;
-            }
+void histogramKernel(const double* p, size_t n, double lo, double hi, size_t bins, double* counts) {
+    size_t chunks = chunkCount(n);
+    std::vector<std::vector<size_t>> partial(chunks, std::vector<size_t>(bins, 0));
+    double scale = hi > lo ? bins / (hi - lo) : 0.0;
+    parallelChunks(n, chunks, [&](size_t c, size_t b, size_t e) {
+        size_t* local = partial[c].data();
+        for (size_t i = b; i < e; ++i) {
+            double v = p[i];
+            if (!(v >= lo && v <= hi)) continue;
+            size_t bin = static_cast<size_t>((v - lo) * scale);
+            local[bin < bins ? bin : bins - 1]++;
+        }
+    });
+    for (size_t k = 0; k < bins; ++k) {
+        size_t total = 0;
+        for (size_t c = 0; c < chunks; ++c) total += partial[c][k];
+        counts[k] = static_cast<double>(total);
+    }
+}
 
-            if (match("output")) {
-                tokens.emplace_back(TokenType::OUTPUT_REDIRECT, "output", line, col);
-                pos += 6;
-                col += 6;
-                while (pos < src.size() && isspace(src[pos])) {
-                    advance();
-                }
-                if (pos < src.size() && src[pos] == '>') {
-                    advance();
-                    in_output_redirect = true;
-                }
-                continue;
-            }
 
-            if (match("input")) {
-                pos += 5;
-                col += 5;
-                while (pos < src.size() && isspace(src[pos])) {
-                    advance();
-                }
-                if (pos < src.size() && src[pos] == '>') {
-                    tokens.emplace_back(TokenType::INPUT_REDIRECT, "input>", line, col - 5);
-                    advance();
-                } else {
-                    tokens.emplace_back(TokenType::IDENTIFIER, "input", line, col - 5);
-                }
-                continue;
-            }
+struct FileMapping {
+    void* base = MAP_FAILED;
+    size_t length = 0;
+    size_t offset = 0;
+    size_t count = 0;
+    bool claimed = false;
+    bool shared = false;
+    std::string path;
 
-            if (match("function")) {
-                tokens.emplace_back(TokenType::FUNCTION, "function", line, col);
-                pos += 8;
-                col += 8;
-                continue;
-            }
+    FileMapping() = default;
+    FileMapping(const FileMapping&) = delete;
+    FileMapping& operator=(const FileMapping&) = delete;
 
-            if (in_output_redirect && c == '>') {
-                tokens.emplace_back(TokenType::OUTPUT_CONNECT, ">", line, col);
-                advance();
-                continue;
-            }
+    ~FileMapping() {
+        if (base != MAP_FAILED) munmap(base, length);
+    }
 
-            if (match("outlb")) {
-                tokens.emplace_back(TokenType::OUTLB, "outlb", line, col);
-                pos += 5;
-                col += 5;
-                continue;
-            }
+    double* data() const {
+        return reinterpret_cast<double*>(static_cast<char*>(base) + offset);
+    }
+};
 
-            if (match("for")) {
-                tokens.emplace_back(TokenType::FOR, "for", line, col);
-                pos += 3;
-                col += 3;
-                continue;
-            }
+template <typename T>
+struct ZeroPageAllocator {
+    using value_type = T;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
 
-            if (match("while")) {
-                tokens.emplace_back(TokenType::WHILE, "while", line, col);
-                pos += 5;
-                col += 5;
-                continue;
-            }
+    std::shared_ptr<FileMapping> mapping;
 
-            if (match("if")) {
-                tokens.emplace_back(TokenType::IF, "if", line, col);
-                pos += 2;
-                col += 2;
-                continue;
-            }
+    ZeroPageAllocator() = default;
+    explicit ZeroPageAllocator(std::shared_ptr<FileMapping> m) : mapping(std::move(m)) {}
+    template <typename U>
+    ZeroPageAllocator(const ZeroPageAllocator<U>& other) : mapping(other.mapping) {}
 
-            if (match("loop")) {
-                tokens.emplace_back(TokenType::LOOP, "loop", line, col);
-                pos += 4;
-                col += 4;
-                continue;
-            }
+    ZeroPageAllocator select_on_container_copy_construction() const {
+        return ZeroPageAllocator();
+    }
 
-            if (match("finish")) {
-                tokens.emplace_back(TokenType::FINISH, "finish", line, col);
-                pos += 6;
-                col += 6;
-                continue;
-            }
+    T* allocate(size_t n) {
+        if (mapping && !mapping->claimed && n * sizeof(T) <= mapping->count * sizeof(double)) {
+            mapping->claimed = true;
+            return reinterpret_cast<T*>(mapping->data());
+        }
+        void* p = std::calloc(n ? n : 1, sizeof(T));
+        if (!p) throw std::bad_alloc();
+        return static_cast<T*>(p);
+    }
 
-            if (isdigit(c)) {
-                size_t start = pos;
-                while (pos < src.size() && isdigit(src[pos])) {
-                    advance();
-                }
-                if (pos < src.size() && src[pos] == '.') {
-                    advance();
-                    while (pos < src.size() && isdigit(src[pos])) {
-                        advance();
-                    }
-                }
-                std::string num = src.substr(start, pos - start);
-                tokens.emplace_back(TokenType::NUMBER, num, line, col - (pos - start));
-                continue;
-            }
+    void deallocate(T* p, size_t) {
+        if (mapping && static_cast<void*>(p) == static_cast<void*>(mapping->data())) return;
+        std::free(p);
+    }
 
-            if (isalpha(c)) {
-                size_t start = pos;
-                while (pos < src.size() && (isalnum(src[pos]) || src[pos] == '_')) {
-                    advance();
-                }
-                std::string word = src.substr(start, pos - start);
-                if (word == "if") {
-                    tokens.emplace_back(TokenType::IF, word, line, col - (pos - start));
-                    continue;
-                }
-                if (word == "while") {
-                    tokens.emplace_back(TokenType::WHILE, word, line, col - (pos - start));
-                    continue;
-                }
-                if (word == "for") {
-                    tokens.emplace_back(TokenType::FOR, word, line, col - (pos - start));
-                    continue;
-                }
-                if (word == "loop") {
-                    tokens.emplace_back(TokenType::LOOP, word, line, col - (pos - start));
-                    continue;
-                }
-                if (word == "outlb") {
-                    tokens.emplace_back(TokenType::OUTLB, word, line, col - (pos - start));
-                    continue;
-                }
-                if (word == "finish") {
-                    tokens.emplace_back(TokenType::FINISH, word, line, col - (pos - start));
-                    continue;
-                }
-                if (word == "function") {
-                    tokens.emplace_back(TokenType::FUNCTION, word, line, col - (pos - start));
-                    continue;
-                }
-                if (word == "accept") {
-                    tokens.emplace_back(TokenType::ACCEPT, word, line, col - (pos - start));
-                    continue;
-                }
-                if (word == "dtime_tic") {
-                    tokens.emplace_back(TokenType::DTIME_TIC, word, line, col - (pos - start));
-                    continue;
-                }
-                if (word == "dtime_toc") {
-                    tokens.emplace_back(TokenType::DTIME_TOC, word, line, col - (pos - start));
-                    continue;
-                }
-                if (word == "random") {
-                    tokens.emplace_back(TokenType::RANDOM, word, line, col - (pos - start));
-                    continue;
-                }
-                tokens.emplace_back(TokenType::IDENTIFIER, word, line, col - (pos - start));
-                continue;
-            }
+    template <typename U>
+    void construct(U* p) {
+        ::new (static_cast<void*>(p)) U;
+    }
 
-            if (c == '.') {
-                advance();
-                if (match("falid")) {
-                    tokens.emplace_back(TokenType::FALID, ".falid", line, col - 1);
-                    pos += 5;
-                    col += 5;
-                } else if (match("valid")) {
-                    tokens.emplace_back(TokenType::VALID, ".valid", line, col - 1);
-                    pos += 5;
-                    col += 5;
-                } else if (match("void")) {
-                    tokens.emplace_back(TokenType::VOID_TYPE, ".void", line, col - 1);
-                    pos += 4;
-                    col += 4;
-                } else {
-                    tokens.emplace_back(TokenType::DOT, ".", line, col - 1);
-                }
-                continue;
-            }
+    template <typename U, typename... Args>
+    void construct(U* p, Args&&... args) {
+        ::new (static_cast<void*>(p)) U(std::forward<Args>(args)...);
+    }
 
-            if (c == '|') {
-                tokens.emplace_back(TokenType::PIPE, "|", line, col);
-                advance();
-                continue;
-            }
+    template <typename U>
+    bool operator==(const ZeroPageAllocator<U>& other) const { return mapping == other.mapping; }
+    template <typename U>
+    bool operator!=(const ZeroPageAllocator<U>& other) const { return mapping != other.mapping; }
+};
 
-            if (c == '=') {
-                advance();
-                if (pos < src.size() && src[pos] == '=') {
-                    tokens.emplace_back(TokenType::EQ, "==", line, col - 1);
-                    advance();
-                } else {
-                    tokens.emplace_back(TokenType::ASSIGN, "=", line, col);
-                }
-                continue;
-            }
+using NumBuffer = std::vector<double, ZeroPageAllocator<double>>;
 
-            if (c == '!') {
-                advance();
-                if (pos < src.size() && src[pos] == '=') {
-                    tokens.emplace_back(TokenType::NEQ, "!=", line, col - 1);
-                    advance();
-                } else {
-                    error(filename, line, col, "不支持的字符 \'" + std::string(1, c) + "\'");
-                }
-                continue;
-            }
+struct ArrayStore {
+    bool numeric = true;
+    bool sparse = false;
+    size_t extent = 0;
+    NumBuffer nums;
+    std::vector<std::string> texts;
+    std::unordered_map<size_t, double> cells;
 
-            if (c == '>') {
-                advance();
-                if (pos < src.size() && src[pos] == '=') {
-                    tokens.emplace_back(TokenType::GTE, ">=", line, col - 1);
-                    advance();
-                } else {
-                    tokens.emplace_back(TokenType::GT, ">", line, col - 1);
-                }
-                continue;
-            }
+    size_t size() const {
+        if (sparse) return extent;
+        return numeric ? nums.size() : texts.size();
+    }
 
-            if (c == '<') {
-                advance();
-                if (pos < src.size() && src[pos] == '=') {
-                    tokens.emplace_back(TokenType::LTE, "<=", line, col - 1);
-                    advance();
-                } else {
-                    tokens.emplace_back(TokenType::LT, "<", line, col - 1);
-                }
-                continue;
-            }
+    std::shared_ptr<FileMapping> mapping() const {
+        std::shared_ptr<FileMapping> m = nums.get_allocator().mapping;
+        if (!m || sparse || !numeric || nums.empty() || nums.data() != m->data()) return nullptr;
+        return m;
+    }
 
-            if (c == '+') {
-                advance();
-                if (pos < src.size() && src[pos] == '=') {
-                    tokens.emplace_back(TokenType::PLUS_EQUALS, "+=", line, col - 1);
-                    advance();
-                } else if (pos < src.size() && src[pos] == '+') {
-                    tokens.emplace_back(TokenType::PLUS_PLUS, "++", line, col - 1);
-                    advance();
-                } else {
-                    tokens.emplace_back(TokenType::PLUS, "+", line, col);
-                }
-                continue;
-            }
+    void densify() {
+        if (!sparse) return;
+        NumBuffer dense(extent);
+        for (const auto& cell : cells) dense[cell.first] = cell.second;
+        nums.swap(dense);
+        std::unordered_map<size_t, double>().swap(cells);
+        sparse = false;
+    }
 
-            if (c == '-') {
-                advance();
-                if (pos < src.size() && src[pos] == '=') {
-                    tokens.emplace_back(TokenType::MINUS_EQUALS, "-=", line, col - 1);
-                    advance();
-                } else if (pos < src.size() && src[pos] == '-') {
-                    tokens.emplace_back(TokenType::MINUS_MINUS, "--", line, col - 1);
-                    advance();
-                } else {
-                    tokens.emplace_back(TokenType::MINUS, "-", line, col);
-                }
-                continue;
-            }
+    void toText() {
+        if (!numeric) return;
+        densify();
+        texts.resize(nums.size());
+        for (size_t i = 0; i < nums.size(); ++i) texts[i] = formatNumber(nums[i]);
+        NumBuffer().swap(nums);
+        numeric = false;
+    }
 
-            if (c == '*') {
-                advance();
-                if (pos < src.size() && src[pos] == '=') {
-                    tokens.emplace_back(TokenType::STAR_EQUALS, "*=", line, col - 1);
-                    advance();
-                } else {
-                    tokens.emplace_back(TokenType::MULTIPLY, "*", line, col);
-                }
-                continue;
-            }
+    double sparseAt(size_t i) const {
+        auto it = cells.find(i);
+        return it == cells.end() ? 0.0 : it->second;
+    }
 
-            if (c == '/') {
-                advance();
-                if (pos < src.size() && src[pos] == '=') {
-                    tokens.emplace_back(TokenType::SLASH_EQUALS, "/=", line, col - 1);
-                    advance();
-                } else {
-                    tokens.emplace_back(TokenType::DIVIDE, "/", line, col);
-                }
-                continue;
-            }
+    double numberAt(size_t i) const {
+        if (sparse) return sparseAt(i);
+        return numeric ? nums[i] : textToNumber(texts[i]);
+    }
 
-            if (c == '[') {
-                tokens.emplace_back(TokenType::LBRACKET, "[", line, col);
-                advance();
-                continue;
-            }
-            if (c == ']') {
-                tokens.emplace_back(TokenType::RBRACKET, "]", line, col);
-                advance();
-                continue;
-            }
+    std::string textAt(size_t i) const {
+        if (sparse) return formatNumber(sparseAt(i));
+        return numeric ? formatNumber(nums[i]) : texts[i];
+    }
 
-            
-            if (c == '~') {
-                tokens.emplace_back(TokenType::TILDE, "~", line, col);
-                advance();
-                continue;
-            }
+    void setNumber(size_t i, double v) {
+        if (sparse) {
+            if (v == 0.0) cells.erase(i);
+            else cells[i] = v;
+        } else if (numeric) {
+            nums[i] = v;
+        } else {
+            texts[i] = formatNumber(v);
+        }
+    }
 
-            switch (c) {
-            case '(': tokens.emplace_back(TokenType::LPAREN, "(", line, col); break;
-            case ')': tokens.emplace_back(TokenType::RPAREN, ")", line, col); break;
-            case '{': tokens.emplace_back(TokenType::LBRACE, "{", line, col); break;
-            case '}': tokens.emplace_back(TokenType::RBRACE, "}", line, col); break;
-            case ';':
-                tokens.emplace_back(TokenType::SEMICOLON, ";", line, col);
-                advance();
-                if (in_output_redirect) in_output_redirect = false;
-                if (in_create) in_create = false;
-                continue;
-            case ',':
-                tokens.emplace_back(TokenType::COMMA, ",", line, col);
-                advance();
-                continue;
-            case '#':
-                while (pos < src.size() && src[pos] != '\n') advance();
-                continue;
-            case '?':
-                tokens.emplace_back(TokenType::QUESTION, "?", line, col);
-                advance();
-                continue;
-            case ':':
-                tokens.emplace_back(TokenType::COLON, ":", line, col);
-                advance();
-                continue;
-            default:
-                if (!isspace(c)) {
-                    error(filename, line, col, "不支持的字符 \'" + std::string(1, c) + "\'");
-                }
-            }
-            advance();
+    void setText(size_t i, const std::string& s) {
+        toText();
+        texts[i] = s;
+    }
+
+    void setValue(size_t i, const std::string& s) {
+        double v;
+        if (numeric && parseNumber(s, v)) {
+            setNumber(i, v);
+            return;
         }
+        setText(i, s);
+    }
 
-        tokens.emplace_back(TokenType::EOF_TOKEN, "", line, col);
-        return tokens;
+    void reserve(size_t n) {
+        densify();
+        if (numeric) nums.reserve(n);
+        else texts.reserve(n);
     }
-};
 
+    void resize(size_t n) {
+        densify();
+        if (numeric) nums.resize(n, 0.0);
+        else texts.resize(n, "0");
+    }
 
-struct Interpreter {
-    std::map<std::string, Variable> vars;
-    std::map<std::string, Function> functions;
-    std::string filename;
-    std::stack<std::map<std::string, Variable>> callStack;
-    TimerState timer;
-    double lastTocTime;
-    bool hasTocExecuted;
-    std::mt19937 rng;  
+    void insertSlot(size_t i) {
+        densify();
+        if (numeric) nums.insert(nums.begin() + i, 0.0);
+        else texts.insert(texts.begin() + i, std::string());
+    }
 
-    Interpreter(const std::string& fname) 
-        : filename(fname), lastTocTime(0.0), hasTocExecuted(false),
-          rng(std::random_device{}()) {}
+    void erase(size_t i) {
+        densify();
+        if (numeric) nums.erase(nums.begin() + i);
+        else texts.erase(texts.begin() + i);
+    }
+};
 
-    
-    void setVar(const std::string& name, VarType type, const std::string& value) {
-        vars[name] = Variable(type, value);
+struct DictKey {
+    bool numeric = true;
+    double num = 0.0;
+    std::string text;
+
+    bool operator==(const DictKey& other) const {
+        if (numeric != other.numeric) return false;
+        return numeric ? num == other.num : text == other.text;
     }
 
-    
-    void setArrayVar(const std::string& name, const std::vector<Variable>& elements) {
-        Variable arr(VarType::ARRAY);
-        arr.arrayElements = elements;
-        if (!elements.empty()) {
-            arr.value = elements[0].value;
-        }
-        vars[name] = arr;
+    std::string toString() const {
+        return numeric ? formatNumber(num) : text;
     }
+};
 
-    
-    void setArrayElement(const std::string& name, size_t index, const Variable& value) {
-        auto it = vars.find(name);
-        if (it == vars.end()) {
-            error(filename, 0, 0, "未声明的数组 \'" + name + "\'");
-        }
-        if (!it->second.isArray()) {
-            error(filename, 0, 0, "变量 \'" + name + "\' 不是数组类型");
-        }
-        if (!it->second.dims.empty()) {
-            it->second.getElement({index}) = value;
-            if (index == 0) {
-                it->second.value = value.value;
-            }
+struct DictStore {
+    struct Entry {
+        uint64_t hash;
+        bool live;
+        DictKey key;
+        DictKey value;
+    };
+
+    static constexpr uint32_t EMPTY = 0xFFFFFFFFu;
+    static constexpr uint32_t DELETED = 0xFFFFFFFEu;
+
+    std::vector<Entry> entries;
+    std::vector<uint32_t> slots;
+    size_t liveCount = 0;
+    size_t usedSlots = 0;
+
+    static uint64_t hashKey(const DictKey& k) {
+        uint64_t h;
+        if (k.numeric) {
+            double d = k.num == 0.0 ? 0.0 : k.num;
+            std::memcpy(&h, &d, sizeof(h));
         } else {
-            if (index >= it->second.getArraySize()) {
-                error(filename, 0, 0, "数组索引越界: " + name + "[" + std::to_string(index) + "]");
-            }
-            it->second.getArrayElement(index) = value;
-            if (index == 0) {
-                it->second.value = value.value;
-            }
+            h = std::hash<std::string>()(k.text) ^ 0x9e3779b97f4a7c15ULL;
         }
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ULL;
+        h ^= h >> 33;
+        return h;
     }
 
-    
-    std::string getVar(const std::string& name) {
-        auto it = vars.find(name);
-        if (it == vars.end()) {
-            error(filename, 0, 0, "未声明的变量 \'" + name + "\'");
-        }
-        if (it->second.isArray()) {
-            return it->second.arrayToString();
-        }
-        return it->second.value;
+    size_t size() const {
+        return liveCount;
     }
 
-    
-    std::string getArrayElement(const std::string& name, size_t index) {
-        auto it = vars.find(name);
-        if (it == vars.end()) {
-            error(filename, 0, 0, "未声明的数组 \'" + name + "\'");
+    size_t findSlot(const DictKey& k, uint64_t h) const {
+        if (slots.empty()) return SIZE_MAX;
+        size_t mask = slots.size() - 1;
+        for (size_t i = h & mask;; i = (i + 1) & mask) {
+            uint32_t e = slots[i];
+            if (e == EMPTY) return SIZE_MAX;
+            if (e != DELETED && entries[e].hash == h && entries[e].key == k) return i;
         }
-        if (!it->second.isArray()) {
-            error(filename, 0, 0, "变量 \'" + name + "\' 不是数组类型");
-        }
-        if (!it->second.dims.empty()) {
-            return it->second.getElement({index}).value;
-        }
-        if (index >= it->second.getArraySize()) {
-            error(filename, 0, 0, "数组索引越界: " + name + "[" + std::to_string(index) + "]");
-        }
-        return it->second.getArrayElement(index).value;
     }
 
-    
-    double getNumericVar(const std::string& name) {
-        auto it = vars.find(name);
-        if (it == vars.end()) {
-            error(filename, 0, 0, "未声明的变量 \'" + name + "\'");
-        }
-        if (!it->second.isNumeric()) {
-            error(filename, 0, 0, "变量 \'" + name + "\' 不是数值类型");
-        }
-        return it->second.getNumericValue();
+    const DictKey* find(const DictKey& k) const {
+        size_t slot = findSlot(k, hashKey(k));
+        return slot == SIZE_MAX ? nullptr : &entries[slots[slot]].value;
     }
 
-    
-    double getNumericArrayElement(const std::string& name, size_t index) {
-        auto it = vars.find(name);
-        if (it == vars.end()) {
-            error(filename, 0, 0, "未声明的数组 \'" + name + "\'");
-        }
-        if (!it->second.isArray()) {
-            error(filename, 0, 0, "变量 \'" + name + "\' 不是数组类型");
-        }
-        if (!it->second.dims.empty()) {
-            return it->second.getElement({index}).getNumericValue();
+    void rebuild(size_t capacity) {
+        size_t cap = 16;
+        while (cap * 3 < capacity * 4 + 4) cap <<= 1;
+        if (liveCount != entries.size()) {
+            size_t out = 0;
+            for (size_t i = 0; i < entries.size(); ++i) {
+                if (entries[i].live) {
+                    if (out != i) entries[out] = std::move(entries[i]);
+                    out++;
+                }
+            }
+            entries.resize(out);
         }
-        if (index >= it->second.getArraySize()) {
-            error(filename, 0, 0, "数组索引越界: " + name + "[" + std::to_string(index) + "]");
+        slots.assign(cap, EMPTY);
+        size_t mask = cap - 1;
+        for (size_t e = 0; e < entries.size(); ++e) {
+            size_t i = entries[e].hash & mask;
+            while (slots[i] != EMPTY) i = (i + 1) & mask;
+            slots[i] = static_cast<uint32_t>(e);
         }
-        return it->second.getArrayElement(index).getNumericValue();
+        usedSlots = entries.size();
     }
 
-    
-    VarType getVarType(const std::string& name) {
-        auto it = vars.find(name);
-        if (it == vars.end()) {
-            error(filename, 0, 0, "未声明的变量 \'" + name + "\'");
-        }
-        return it->second.type;
+    void reserve(size_t n) {
+        if (n <= entries.size()) return;
+        entries.reserve(n);
+        if ((n + 1) * 4 > slots.size() * 3) rebuild(n);
     }
 
-    
-    size_t getArraySize(const std::string& name) {
-        auto it = vars.find(name);
-        if (it == vars.end()) {
-            error(filename, 0, 0, "未声明的数组 \'" + name + "\'");
-        }
-        if (!it->second.isArray()) {
-            error(filename, 0, 0, "变量 \'" + name + "\' 不是数组类型");
+    DictKey& insert(const DictKey& k) {
+        uint64_t h = hashKey(k);
+        size_t slot = findSlot(k, h);
+        if (slot != SIZE_MAX) return entries[slots[slot]].value;
+        if ((usedSlots + 1) * 4 > slots.size() * 3) {
+            rebuild(std::max<size_t>(liveCount * 2, 8));
         }
-        return it->second.getArraySize();
+        size_t mask = slots.size() - 1;
+        size_t i = h & mask;
+        while (slots[i] != EMPTY && slots[i] != DELETED) i = (i + 1) & mask;
+        if (slots[i] == EMPTY) usedSlots++;
+        slots[i] = static_cast<uint32_t>(entries.size());
+        entries.push_back(Entry{h, true, k, DictKey()});
+        liveCount++;
+        return entries.back().value;
     }
 
-    
-    bool hasVar(const std::string& name) {
-        return vars.find(name) != vars.end();
+    bool erase(const DictKey& k) {
+        size_t slot = findSlot(k, hashKey(k));
+        if (slot == SIZE_MAX) return false;
+        Entry& entry = entries[slots[slot]];
+        entry.live = false;
+        entry.key = DictKey();
+        entry.value = DictKey();
+        slots[slot] = DELETED;
+        liveCount--;
+        if (entries.size() > 32 && liveCount * 2 < entries.size()) rebuild(liveCount);
+        return true;
     }
 
-    
-    bool isArrayVar(const std::string& name) {
-        auto it = vars.find(name);
-        if (it == vars.end()) return false;
-        return it->second.isArray();
+    void clear() {
+        entries.clear();
+        slots.clear();
+        liveCount = 0;
+        usedSlots = 0;
     }
 
-    
-    std::string getTypeName(VarType type) {
-        switch (type) {
-        case VarType::INT: return "int";
-        case VarType::DOUBLE: return "double";
-        case VarType::OMNI: return "omni";
-        case VarType::STRING: return "string";
-        case VarType::ARRAY: return "array";
-        default: return "unknown";
+    template <typename F>
+    void forEach(F&& f) const {
+        for (const Entry& entry : entries) {
+            if (entry.live) f(entry.key, entry.value);
         }
     }
+};
 
-    
-    double stringToDouble(const std::string& str) {
-        try {
-            return std::stod(str);
-        } catch (const std::exception&) {
-            error(filename, 0, 0, "无法将字符串 \'" + str + "\' 转换为数字");
-            return 0;
-        }
+struct HeapStore {
+    bool maxHeap = false;
+    bool hasPayload = false;
+    std::vector<double> keys;
+    std::vector<double> payloads;
+
+    bool before(double a, double b) const {
+        return maxHeap ? a > b : a < b;
     }
 
-    
-    std::string doubleToString(double num) {
-        if (num == static_cast<long long>(num)) {
-            return std::to_string(static_cast<long long>(num));
-        }
-        std::string s = std::to_string(num);
-        s.erase(s.find_last_not_of('0') + 1, std::string::npos);
-        if (s.back() == '.') {
-            s.erase(s.find_last_not_of('.') + 1, std::string::npos);
-        }
-        return s;
+    void swapAt(size_t i, size_t j) {
+        std::swap(keys[i], keys[j]);
+        if (hasPayload) std::swap(payloads[i], payloads[j]);
     }
 
-private:
-    
-    double parseFactor(const std::vector<Token>& tokens, size_t& index) {
-        if (index >= tokens.size()) {
-            error(filename, 0, 0, "表达式意外结束");
+    void siftUp(size_t i) {
+        while (i > 0) {
+            size_t parent = (i - 1) / 2;
+            if (!before(keys[i], keys[parent])) break;
+            swapAt(i, parent);
+            i = parent;
         }
+    }
 
-        if (tokens[index].type == TokenType::MINUS) {
-            index++;
-            return -parseFactor(tokens, index);
+    void siftDown(size_t i) {
+        size_t n = keys.size();
+        while (true) {
+            size_t best = i;
+            size_t left = 2 * i + 1;
+            if (left < n && before(keys[left], keys[best])) best = left;
+            if (left + 1 < n && before(keys[left + 1], keys[best])) best = left + 1;
+            if (best == i) return;
+            swapAt(i, best);
+            i = best;
         }
+    }
 
-        if (tokens[index].type == TokenType::LPAREN) {
-            index++;
-            double result = parseExpression(tokens, index);
-            if (index >= tokens.size() || tokens[index].type != TokenType::RPAREN) {
-                error(filename, tokens[index].line, tokens[index].col, "缺少闭合括号 \')\'");
-            }
-            index++;
-            return result;
-        }
+    void enablePayload() {
+        if (hasPayload) return;
+        payloads.assign(keys.size(), 0.0);
+        hasPayload = true;
+    }
 
-        if (tokens[index].type == TokenType::NUMBER) {
-            double value = stringToDouble(tokens[index].lexeme);
-            index++;
-            return value;
-        }
+    void push(double key, double payload = 0.0) {
+        keys.push_back(key);
+        if (hasPayload) payloads.push_back(payload);
+        siftUp(keys.size() - 1);
+    }
 
-        if (tokens[index].type == TokenType::IDENTIFIER) {
-            std::string varName = tokens[index].lexeme;
-            index++;
+    void pop() {
+        swapAt(0, keys.size() - 1);
+        keys.pop_back();
+        if (hasPayload) payloads.pop_back();
+        if (!keys.empty()) siftDown(0);
+    }
 
-            if (index < tokens.size() && tokens[index].type == TokenType::LBRACKET) {
-                index++;
-                double idxValue = parseExpression(tokens, index);
-                if (index >= tokens.size() || tokens[index].type != TokenType::RBRACKET) {
-                    error(filename, tokens[index].line, tokens[index].col, "缺少闭合方括号 \']\'");
-                }
-                index++;
+    void heapify() {
+        for (size_t i = keys.size() / 2; i-- > 0;) siftDown(i);
+    }
+};
 
-                size_t arrayIndex = static_cast<size_t>(idxValue);
-                if (idxValue < 0 || idxValue != static_cast<long long>(idxValue)) {
-                    error(filename, 0, 0, "数组索引必须是正整数");
-                }
+struct SortedIndex {
+    std::vector<double> layout;
+    std::vector<size_t> rank;
+    std::vector<size_t> order;
 
-                auto it = vars.find(varName);
-                if (it != vars.end() && !it->second.dims.empty()) {
-                    return it->second.getElement({arrayIndex}).getNumericValue();
-                }
-                return getNumericArrayElement(varName, arrayIndex);
-            }
+    size_t size() const {
+        return order.size();
+    }
 
-            return getNumericVar(varName);
+    void build(const double* p, size_t n) {
+        order.clear();
+        for (size_t i = 0; i < n; ++i) {
+            if (!std::isnan(p[i])) order.push_back(i);
         }
+        std::stable_sort(order.begin(), order.end(), [p](size_t a, size_t b) { return p[a] < p[b]; });
+        size_t m = order.size();
+        layout.assign(m + 1, 0.0);
+        rank.assign(m + 1, 0);
+        size_t next = 0;
+        fill(p, 1, next);
+    }
 
-        if (tokens[index].type == TokenType::DTIME_FUNC) {
-            index++;
-            if (!hasTocExecuted) {
-                error(filename, tokens[index-1].line, tokens[index-1].col, 
-                      "dtime() 必须在 dtime_toc 之后使用");
+    template <bool Upper>
+    size_t bound(double x) const {
+        size_t n = order.size();
+        size_t k = 1;
+        while (k <= n) {
+            k = 2 * k + (Upper ? !(x < layout[k]) : layout[k] < x);
+        }
+        while (k & 1) k >>= 1;
+        k >>= 1;
+        return k == 0 ? n : rank[k];
+    }
+
+private:
+    void fill(const double* p, size_t k, size_t& next) {
+        if (k >= layout.size()) return;
+        fill(p, 2 * k, next);
+        layout[k] = p[order[next]];
+        rank[k] = next++;
+        fill(p, 2 * k + 1, next);
+    }
+};
+
+struct RecordLayout {
+    std::string name;
+    std::vector<std::string> fields;
+    const size_t id = nextId();
+
+    static size_t nextId() {
+        static size_t counter = 0;
+        return ++counter;
+    }
+
+    size_t fieldIndex(const Token& field) const {
+        if (field.cacheKey == id && field.cacheSlot < fields.size()) return field.cacheSlot;
+        for (size_t i = 0; i < fields.size(); ++i) {
+            if (fields[i] == field.lexeme) {
+                field.cacheKey = id;
+                field.cacheSlot = i;
+                return i;
             }
-            return lastTocTime;
         }
+        return SIZE_MAX;
+    }
+};
 
-        error(filename, tokens[index].line, tokens[index].col,
-              "表达式中期望数字、变量或括号，但得到 \'" + tokens[index].lexeme + "\'");
-        return 0.0;
+struct RecordStore {
+    std::shared_ptr<const RecordLayout> layout;
+    size_t count = 0;
+    std::vector<std::shared_ptr<ArrayStore>> columns;
+
+    RecordStore(std::shared_ptr<const RecordLayout> l, size_t n) : layout(std::move(l)), count(n) {
+        for (size_t i = 0; i < layout->fields.size(); ++i) {
+            columns.push_back(std::make_shared<ArrayStore>());
+            columns.back()->nums = NumBuffer(n);
+        }
     }
 
-    
-    double parseTerm(const std::vector<Token>& tokens, size_t& index) {
-        double result = parseFactor(tokens, index);
-        while (index < tokens.size() &&
-               (tokens[index].type == TokenType::MULTIPLY ||
-                tokens[index].type == TokenType::DIVIDE)) {
-            std::string op = tokens[index].lexeme;
-            index++;
-            double right = parseFactor(tokens, index);
-            result = performArithmeticOp(result, op, right);
+    std::string rowToString(size_t row) const {
+        std::string r = "{";
+        for (size_t f = 0; f < columns.size(); ++f) {
+            if (f > 0) r += ", ";
+            r += layout->fields[f] + ": " + columns[f]->textAt(row);
         }
-        return result;
+        return r + "}";
     }
+};
 
-    
-    double parseExpression(const std::vector<Token>& tokens, size_t& index) {
-        double result = parseTerm(tokens, index);
-        while (index < tokens.size() &&
-               (tokens[index].type == TokenType::PLUS ||
-                tokens[index].type == TokenType::MINUS)) {
-            std::string op = tokens[index].lexeme;
-            index++;
-            double right = parseTerm(tokens, index);
-            result = performArithmeticOp(result, op, right);
-        }
-        return result;
+struct ArrayFileHeader {
+    static constexpr char MAGIC[8] = {'W', 'L', 'A', 'R', 'R', 'A', 'Y', '\0'};
+    static constexpr uint32_t VERSION = 1;
+    static constexpr uint32_t ENDIAN_MARK = 0x01020304;
+    static constexpr uint32_t FLOAT64 = 1;
+    static constexpr uint32_t TEXT = 2;
+    static constexpr size_t ALIGN = 64;
+
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint32_t dtype;
+    uint32_t rank;
+    uint64_t count;
+    uint64_t dataOffset;
+    uint64_t dataBytes;
+    uint64_t reserved[2];
+};
+
+static_assert(sizeof(ArrayFileHeader) == ArrayFileHeader::ALIGN, "array file header must fill one cache line");
+
+struct CsvReader {
+    static constexpr size_t CHUNK = 1 << 20;
+
+    std::string path;
+    int fd = -1;
+    std::vector<char> buf;
+    size_t pos = 0;
+    size_t len = 0;
+    bool eof = false;
+    char delim = ',';
+    size_t line = 0;
+    size_t chunkRows = 0;
+    std::string types;
+    std::string problem;
+    std::shared_ptr<const RecordLayout> layout;
+    std::vector<std::string_view> fields;
+    std::deque<std::string> unescaped;
+
+    ~CsvReader() {
+        if (fd >= 0) ::close(fd);
     }
 
-    
-    double performArithmeticOp(double left, const std::string& op, double right) {
-        if (op == "+") return left + right;
-        if (op == "-") return left - right;
-        if (op == "*") return left * right;
-        if (op == "/") {
-            if (right == 0) error(filename, 0, 0, "除零错误");
-            return left / right;
-        }
-        error(filename, 0, 0, "未知运算符 \'" + op + "\'");
-        return 0;
+    bool open(const std::string& file) {
+        path = file;
+        fd = ::open(file.c_str(), O_RDONLY);
+        return fd >= 0;
     }
 
-public:
-    
-    double evaluateExpr(const std::vector<Token>& tokens, size_t& index) {
-        return parseExpression(tokens, index);
+    bool refill() {
+        if (eof) return false;
+        if (pos > 0) {
+            memmove(buf.data(), buf.data() + pos, len - pos);
+            len -= pos;
+            pos = 0;
+        }
+        if (buf.size() - len < CHUNK / 2) buf.resize(std::max(buf.size() * 2, len + CHUNK));
+        ssize_t r;
+        do {
+            r = ::read(fd, buf.data() + len, buf.size() - len);
+        } while (r < 0 && errno == EINTR);
+        if (r <= 0) {
+            eof = true;
+            return false;
+        }
+        len += static_cast<size_t>(r);
+        return true;
     }
 
-    
-    std::vector<Variable> parseMultiArrayInitializer(const std::vector<Token>& tokens, size_t& ip, 
-                                                     std::vector<size_t>& dims) {
-        std::vector<Variable> elements;
+    bool findRecordEnd(size_t& end, bool& quoted) const {
+        quoted = false;
+        if (pos >= len) return false;
+        const char* b = buf.data() + pos;
+        const char* e = buf.data() + len;
+        const char* nl = static_cast<const char*>(memchr(b, '\n', e - b));
+        const char* q = static_cast<const char*>(memchr(b, '"', (nl ? nl : e) - b));
+        if (!q) {
+            quoted = false;
+            if (!nl) return false;
+            end = static_cast<size_t>(nl - buf.data());
+            return true;
+        }
+        quoted = true;
+        bool inQuote = false;
+        for (const char* p = q; p < e; ++p) {
+            if (*p == '"') {
+                inQuote = !inQuote;
+            } else if (*p == '\n' && !inQuote) {
+                end = static_cast<size_t>(p - buf.data());
+                return true;
+            }
+        }
+        return false;
+    }
 
-        if (tokens[ip].type != TokenType::LBRACE) {
-            error(filename, tokens[ip].line, tokens[ip].col, "数组初始化缺少 \'{\'");
+    bool nextRecord() {
+        while (true) {
+            size_t end = 0;
+            bool quoted = false;
+            bool last = false;
+            while (!findRecordEnd(end, quoted)) {
+                if (!refill()) {
+                    if (pos >= len) return false;
+                    end = len;
+                    quoted = memchr(buf.data() + pos, '"', len - pos) != nullptr;
+                    last = true;
+                    break;
+                }
+            }
+            line++;
+            size_t stop = end;
+            if (stop > pos && buf[stop-1] == '\r') stop--;
+            size_t start = pos;
+            pos = last ? len : end + 1;
+            if (stop == start) continue;
+            return quoted ? splitQuoted(start, stop) : splitPlain(start, stop);
         }
-        ip++;
+    }
 
-        size_t currentDimSize = 0;
-        std::vector<size_t> subDims;
+    bool splitPlain(size_t start, size_t stop) {
+        fields.clear();
+        const char* p = buf.data() + start;
+        const char* e = buf.data() + stop;
+        while (true) {
+            const char* d = static_cast<const char*>(memchr(p, delim, e - p));
+            if (!d) {
+                fields.emplace_back(p, static_cast<size_t>(e - p));
+                return true;
+            }
+            fields.emplace_back(p, static_cast<size_t>(d - p));
+            p = d + 1;
+        }
+    }
 
-        while (ip < tokens.size() && tokens[ip].type != TokenType::RBRACE) {
-            if (tokens[ip].type == TokenType::LBRACE) {
-                std::vector<size_t> innerDims;
-                std::vector<Variable> subElements = parseMultiArrayInitializer(tokens, ip, innerDims);
-                elements.insert(elements.end(), subElements.begin(), subElements.end());
-                currentDimSize++;
-
-                if (subDims.empty()) {
-                    subDims = innerDims;
-                } else {
-                    if (subDims != innerDims) {
-                        error(filename, tokens[ip].line, tokens[ip].col, "多维数组各维度大小不一致");
+    bool splitQuoted(size_t start, size_t stop) {
+        fields.clear();
+        size_t used = 0;
+        const char* p = buf.data() + start;
+        const char* e = buf.data() + stop;
+        while (true) {
+            if (p < e && *p == '"') {
+                const char* b = ++p;
+                bool escaped = false;
+                while (true) {
+                    const char* q = static_cast<const char*>(memchr(p, '"', e - p));
+                    if (!q) {
+                        problem = "第 " + std::to_string(line) + " 行的引号没有闭合";
+                        return false;
+                    }
+                    if (q + 1 < e && q[1] == '"') {
+                        escaped = true;
+                        p = q + 2;
+                        continue;
                     }
+                    p = q;
+                    break;
                 }
-            } else {
-                if (tokens[ip].type == TokenType::NUMBER) {
-                    elements.push_back(Variable(VarType::OMNI, tokens[ip].lexeme));
-                    ip++;
-                } else if (tokens[ip].type == TokenType::STRING) {
-                    elements.push_back(Variable(VarType::OMNI, tokens[ip].lexeme));
-                    ip++;
-                } else if (tokens[ip].type == TokenType::IDENTIFIER) {
-                    elements.push_back(Variable(VarType::OMNI, getVar(tokens[ip].lexeme)));
-                    ip++;
+                if (escaped) {
+                    if (unescaped.size() <= used) unescaped.emplace_back();
+                    std::string& text = unescaped[used++];
+                    text.clear();
+                    for (const char* c = b; c < p; ++c) {
+                        text.push_back(*c);
+                        if (*c == '"') ++c;
+                    }
+                    fields.emplace_back(text);
                 } else {
-                    error(filename, tokens[ip].line, tokens[ip].col, "数组元素必须是数字、字符串或标识符");
+                    fields.emplace_back(b, static_cast<size_t>(p - b));
                 }
-                currentDimSize++;
+                p++;
+                if (p == e) return true;
+                if (*p != delim) {
+                    problem = "第 " + std::to_string(line) + " 行的引号字段后必须紧跟分隔符";
+                    return false;
+                }
+                p++;
+                continue;
             }
-
-            if (ip < tokens.size() && tokens[ip].type == TokenType::COMMA) {
-                ip++;
+            const char* d = static_cast<const char*>(memchr(p, delim, e - p));
+            if (!d) {
+                fields.emplace_back(p, static_cast<size_t>(e - p));
+                return true;
             }
+            fields.emplace_back(p, static_cast<size_t>(d - p));
+            p = d + 1;
         }
+    }
+};
 
-        if (ip >= tokens.size() || tokens[ip].type != TokenType::RBRACE) {
-            error(filename, tokens[ip].line, tokens[ip].col, "数组初始化缺少 \'}\'");
-        }
-        ip++;
+struct Subscript {
+    bool range = false;
+    bool hasLo = false;
+    bool hasHi = false;
+    size_t lo = 0;
+    size_t hi = 0;
+    size_t step = 1;
+};
 
-        dims.clear();
-        dims.push_back(currentDimSize);
-        dims.insert(dims.end(), subDims.begin(), subDims.end());
+struct Variable {
+    VarType type;
+    std::string value;
+    std::vector<size_t> dims;
+    std::vector<size_t> strides;
+    size_t offset = 0;
+    std::shared_ptr<ArrayStore> store;
+    std::shared_ptr<DictStore> dict;
+    std::shared_ptr<RecordStore> records;
+    std::shared_ptr<HeapStore> heap;
+    std::shared_ptr<const SortedIndex> sorted;
+    std::shared_ptr<TDigest> digest;
+    std::shared_ptr<CsvReader> csv;
 
-        return elements;
-    }
+    Variable(VarType t = VarType::DOUBLE, const std::string& v = "0")
+        : type(t), value(v) {}
 
-    
-    void loadLibrary(const std::string& libName) {
-        std::string libFilename = libName;
-        if (libFilename.find('.') == std::string::npos) {
-            libFilename += ".lib";
-        }
-        std::ifstream libFile(libFilename);
-        if (!libFile.is_open()) {
-            error(filename, 0, 0, "无法打开库文件 \'" + libFilename + "\'");
-            return;
-        }
-        std::string libSrc((std::istreambuf_iterator<char>(libFile)),
-                          std::istreambuf_iterator<char>());
-        libFile.close();
-        Scanner libScanner(libSrc, libFilename);
-        auto libTokens = libScanner.scan();
-        execute(libTokens);
+    bool isNumeric() const {
+        return type == VarType::INT || type == VarType::DOUBLE || type == VarType::OMNI;
+    }
+ 
+    bool isArray() const {
+        return type == VarType::ARRAY;
     }
 
-    
-    std::string evaluateTernary(const std::vector<Token>& tokens, size_t& index) {
-        if (tokens[index].type != TokenType::IDENTIFIER) {
-            error(filename, tokens[index].line, tokens[index].col,
-                  "三元运算符条件必须是标识符");
-        }
-        std::string condVar = tokens[index].lexeme;
-        double condValue = getNumericVar(condVar);
-        index++;
-        if (index >= tokens.size() || tokens[index].type != TokenType::QUESTION) {
-            error(filename, tokens[index].line, tokens[index].col,
-                  "三元表达式缺少问号");
-        }
-        index++;
-        std::string trueValue;
-        if (tokens[index].type == TokenType::STRING) {
-            trueValue = tokens[index].lexeme;
-            index++;
-        } else if (tokens[index].type == TokenType::NUMBER) {
-            trueValue = tokens[index].lexeme;
-            index++;
-        } else if (tokens[index].type == TokenType::IDENTIFIER) {
-            trueValue = getVar(tokens[index].lexeme);
-            index++;
-        } else {
-            error(filename, tokens[index].line, tokens[index].col,
-                  "三元表达式真分支格式错误");
-        }
-        if (index >= tokens.size() || tokens[index].type != TokenType::COLON) {
-            error(filename, tokens[index].line, tokens[index].col,
-                  "三元表达式缺少冒号");
-        }
-        index++;
-        std::string falseValue;
-        if (tokens[index].type == TokenType::STRING) {
-            falseValue = tokens[index].lexeme;
-            index++;
-        } else if (tokens[index].type == TokenType::NUMBER) {
-            falseValue = tokens[index].lexeme;
-            index++;
-        } else if (tokens[index].type == TokenType::IDENTIFIER) {
-            falseValue = getVar(tokens[index].lexeme);
-            index++;
-        } else {
-            error(filename, tokens[index].line, tokens[index].col,
-                  "三元表达式假分支格式错误");
-        }
-        return condValue != 0 ? trueValue : falseValue;
+    bool isDict() const {
+        return type == VarType::DICT;
     }
 
-    
-    std::vector<Variable> parseArrayInitializer(const std::vector<Token>& tokens, size_t& ip) {
-        std::vector<Variable> elements;
+    bool isRecord() const {
+        return type == VarType::RECORD;
+    }
 
-        if (tokens[ip].type != TokenType::LBRACE) {
-            error(filename, tokens[ip].line, tokens[ip].col, "数组初始化缺少 \'{\'");
-        }
-        ip++;
+    bool isHeap() const {
+        return type == VarType::HEAP;
+    }
 
-        while (ip < tokens.size() && tokens[ip].type != TokenType::RBRACE) {
-            if (tokens[ip].type == TokenType::NUMBER) {
-                elements.push_back(Variable(VarType::OMNI, tokens[ip].lexeme));
-                ip++;
-            } else if (tokens[ip].type == TokenType::STRING) {
-                elements.push_back(Variable(VarType::OMNI, tokens[ip].lexeme));
-                ip++;
-            } else if (tokens[ip].type == TokenType::IDENTIFIER) {
-                elements.push_back(Variable(VarType::OMNI, getVar(tokens[ip].lexeme)));
-                ip++;
-            } else {
-                error(filename, tokens[ip].line, tokens[ip].col, "数组元素必须是数字、字符串或标识符");
-            }
+    bool isIndex() const {
+        return type == VarType::INDEX;
+    }
 
-            if (ip < tokens.size() && tokens[ip].type == TokenType::COMMA) {
-                ip++;
-            }
-        }
+    bool isDigest() const {
+        return type == VarType::DIGEST;
+    }
 
-        if (ip >= tokens.size() || tokens[ip].type != TokenType::RBRACE) {
-            error(filename, tokens[ip].line, tokens[ip].col, "数组初始化缺少 \'}\'");
-        }
-        ip++;
+    bool isCsv() const {
+        return type == VarType::CSV;
+    }
 
-        return elements;
+    bool isContainer() const {
+        return isArray() || isDict() || isRecord() || isHeap() || isIndex() || isDigest() || isCsv();
     }
 
-    
-    bool parseVariableDeclaration(const std::vector<Token>& tokens, size_t& ip) {
-        TokenType declType = tokens[ip].type;
-        if (declType != TokenType::CREATE_INT &&
-            declType != TokenType::CREATE_DOUBLE &&
-            declType != TokenType::CREATE_OMNI &&
-            declType != TokenType::CREATE_STRING &&
-            declType != TokenType::CREATE_ARR) {
-            return false;
-        }
+    double getNumericValue() const {
+        return textToNumber(value);
+    }
 
-        
-        if (ip + 2 < tokens.size() &&
-            tokens[ip+1].type == TokenType::IDENTIFIER &&
-            tokens[ip+2].type == TokenType::SEMICOLON) {
+    std::string scalarValue() const {
+        if (!isArray()) return value;
+        return elementCount() > 0 ? store->textAt(offset) : "";
+    }
 
-            if (declType == TokenType::CREATE_ARR) {
-                
-                return false;
-            }
+    static std::vector<size_t> rowMajorStrides(const std::vector<size_t>& shape) {
+        std::vector<size_t> result(shape.size(), 1);
+        for (size_t k = shape.size(); k-- > 1;) result[k-1] = result[k] * shape[k];
+        return result;
+    }
 
-            std::string name = tokens[ip+1].lexeme;
-            VarType type = VarType::DOUBLE;
-            if (declType == TokenType::CREATE_INT) type = VarType::INT;
-            else if (declType == TokenType::CREATE_DOUBLE) type = VarType::DOUBLE;
-            else if (declType == TokenType::CREATE_OMNI) type = VarType::OMNI;
-            else if (declType == TokenType::CREATE_STRING) type = VarType::STRING;
+    void setDims(const std::vector<size_t>& dimensions) {
+        dims = dimensions;
+        strides = rowMajorStrides(dims);
+        offset = 0;
+        size_t total = 1;
+        for (size_t d : dims) total *= d;
+        store = std::make_shared<ArrayStore>();
+        store->nums = NumBuffer(total);
+    }
 
-            std::string initVal = (type == VarType::STRING) ? "" : "0";
-            setVar(name, type, initVal);
-            ip += 3;
-            return true;
-        }
+    void setSparseDims(const std::vector<size_t>& dimensions) {
+        dims = dimensions;
+        strides = rowMajorStrides(dims);
+        offset = 0;
+        size_t total = 1;
+        for (size_t d : dims) total *= d;
+        store = std::make_shared<ArrayStore>();
+        store->sparse = true;
+        store->extent = total;
+    }
 
-        
-        if (declType == TokenType::CREATE_ARR && ip + 5 < tokens.size() &&
-            tokens[ip+1].type == TokenType::IDENTIFIER &&
-            tokens[ip+2].type == TokenType::ASSIGN &&
-            tokens[ip+3].type == TokenType::LBRACE) {
+    size_t elementCount() const {
+        if (!store || dims.empty()) return 0;
+        size_t total = 1;
+        for (size_t d : dims) total *= d;
+        return total;
+    }
 
-            size_t tempIp = ip;
-            std::string name = tokens[tempIp+1].lexeme;
-            tempIp += 3;
+    bool isContiguous() const {
+        size_t expected = 1;
+        for (size_t k = dims.size(); k-- > 0;) {
+            if (dims[k] != 1 && strides[k] != expected) return false;
+            expected *= dims[k];
+        }
+        return true;
+    }
 
-            std::vector<size_t> dims;
-            std::vector<Variable> elements = parseMultiArrayInitializer(tokens, tempIp, dims);
+    bool isView() const {
+        return store && (offset != 0 || elementCount() != store->size() || !isContiguous());
+    }
 
-            if (tempIp < tokens.size() && tokens[tempIp].type == TokenType::SEMICOLON) {
-                if (dims.empty()) {
-                    setArrayVar(name, elements);
-                } else {
-                    size_t total = 1;
-                    for (size_t d : dims) total *= d;
-                    if (elements.size() != total) {
-                        error(filename, tokens[ip].line, tokens[ip].col, 
-                              "数组初始化元素数量不匹配，期望 " + std::to_string(total) + 
-                              " 个，实际 " + std::to_string(elements.size()) + " 个");
-                    }
-                    Variable arr(VarType::ARRAY);
-                    arr.setDims(dims);
-                    for (size_t i = 0; i < elements.size(); i++) {
-                        arr.flatData[i] = elements[i];
-                    }
-                    vars[name] = arr;
+    template <typename F>
+    static void forEachIndexOf(const std::vector<size_t>& shape, const std::vector<size_t>& step,
+                               size_t base, F&& f) {
+        size_t total = 1;
+        for (size_t d : shape) total *= d;
+        if (total == 0) return;
+        std::vector<size_t> idx(shape.size(), 0);
+        size_t phys = base;
+        for (size_t i = 0; i < total; ++i) {
+            f(i, phys);
+            for (size_t k = shape.size(); k-- > 0;) {
+                if (++idx[k] < shape[k]) {
+                    phys += step[k];
+                    break;
                 }
-                ip = tempIp + 1;
-                return true;
+                phys -= step[k] * (shape[k] - 1);
+                idx[k] = 0;
             }
         }
+    }
 
-        
-        if (declType == TokenType::CREATE_ARR && ip + 4 < tokens.size() &&
-            tokens[ip+1].type == TokenType::IDENTIFIER) {
+    template <typename F>
+    void forEachIndex(F&& f) const {
+        if (isContiguous()) {
+            size_t n = elementCount();
+            for (size_t i = 0; i < n; ++i) f(i, offset + i);
+            return;
+        }
+        forEachIndexOf(dims, strides, offset, f);
+    }
 
-            size_t tempIp = ip + 2;
-            std::string name = tokens[ip+1].lexeme;
-            std::vector<size_t> dims;
+    size_t flattenIndex(const std::vector<size_t>& indices) const {
+        if (indices.size() != dims.size()) {
+            throw std::runtime_error("维度不匹配");
+        }
+        size_t idx = offset;
+        for (size_t i = 0; i < dims.size(); i++) {
+            if (indices[i] >= dims[i]) {
+                throw std::runtime_error("索引越界");
+            }
+            idx += indices[i] * strides[i];
+        }
+        return idx;
+    }
 
-            while (tempIp < tokens.size() && tokens[tempIp].type == TokenType::LBRACKET) {
-                tempIp++;
-                if (tempIp < tokens.size() && tokens[tempIp].type == TokenType::NUMBER) {
-                    size_t size = static_cast<size_t>(stringToDouble(tokens[tempIp].lexeme));
-                    dims.push_back(size);
-                    tempIp++;
-                    if (tempIp < tokens.size() && tokens[tempIp].type == TokenType::RBRACKET) {
-                        tempIp++;
-                    } else {
-                        break;
-                    }
-                } else {
-                    break;
-                }
+    template <size_t Rank>
+    size_t elementIndex(const std::array<size_t, Rank>& idx) const {
+        if (dims.size() != Rank) {
+            throw std::runtime_error("维度不匹配");
+        }
+        size_t phys = offset;
+        for (size_t k = 0; k < Rank; ++k) {
+            if (idx[k] >= dims[k]) {
+                throw std::runtime_error("索引越界");
             }
+            phys += idx[k] * strides[k];
+        }
+        return phys;
+    }
 
-            if (!dims.empty() && tempIp < tokens.size() && tokens[tempIp].type == TokenType::SEMICOLON) {
-                Variable arr(VarType::ARRAY);
-                arr.setDims(dims);
-                vars[name] = arr;
-                ip = tempIp + 1;
-                return true;
+    Variable slice(const std::vector<Subscript>& subs) const {
+        if (subs.size() > dims.size()) {
+            throw std::runtime_error("维度不匹配");
+        }
+        Variable view(VarType::ARRAY);
+        view.store = store;
+        view.offset = offset;
+        for (size_t k = 0; k < dims.size(); ++k) {
+            if (k >= subs.size()) {
+                view.dims.push_back(dims[k]);
+                view.strides.push_back(strides[k]);
+                continue;
+            }
+            const Subscript& sub = subs[k];
+            if (!sub.range) {
+                if (sub.lo >= dims[k]) throw std::runtime_error("索引越界");
+                view.offset += sub.lo * strides[k];
+                continue;
             }
+            size_t lo = sub.hasLo ? sub.lo : 0;
+            size_t hi = sub.hasHi ? sub.hi : dims[k];
+            if (lo > hi || hi > dims[k] || sub.step == 0) throw std::runtime_error("切片范围越界");
+            view.dims.push_back((hi - lo + sub.step - 1) / sub.step);
+            view.strides.push_back(strides[k] * sub.step);
+            view.offset += lo * strides[k];
         }
+        return view;
+    }
 
-        
-        if (ip + 4 < tokens.size() &&
-            tokens[ip+1].type == TokenType::IDENTIFIER &&
-            tokens[ip+2].type == TokenType::ASSIGN &&
-            (tokens[ip+3].type == TokenType::NUMBER ||
-             tokens[ip+3].type == TokenType::STRING ||
-             tokens[ip+3].type == TokenType::IDENTIFIER) &&
-            tokens[ip+4].type == TokenType::SEMICOLON) {
+    std::string getElement(const std::vector<size_t>& indices) const {
+        return store->textAt(flattenIndex(indices));
+    }
 
-            std::string name = tokens[ip+1].lexeme;
-            VarType type = VarType::DOUBLE;
-            if (declType == TokenType::CREATE_INT) type = VarType::INT;
-            else if (declType == TokenType::CREATE_DOUBLE) type = VarType::DOUBLE;
-            else if (declType == TokenType::CREATE_OMNI) type = VarType::OMNI;
-            else if (declType == TokenType::CREATE_STRING) type = VarType::STRING;
+    double getNumericElement(const std::vector<size_t>& indices) const {
+        return store->numberAt(flattenIndex(indices));
+    }
 
-            const Token& rightToken = tokens[ip+3];
+    void setPhysical(size_t phys, const Variable& v) {
+        if (v.type == VarType::STRING) store->setText(phys, v.value);
+        else store->setValue(phys, v.value);
+    }
 
-            if (rightToken.type == TokenType::NUMBER) {
-                setVar(name, type, rightToken.lexeme);
-            } else if (rightToken.type == TokenType::STRING) {
-                setVar(name, type, rightToken.lexeme);
-            } else if (rightToken.type == TokenType::IDENTIFIER) {
-                
-                if (!hasVar(rightToken.lexeme)) {
-                    error(filename, rightToken.line, rightToken.col,
-                          "赋值时右侧变量 \'" + rightToken.lexeme + "\' 未声明");
-                }
-                Variable rightVar = vars[rightToken.lexeme];
-                setVar(name, type, rightVar.value);
-            }
-            ip += 5;
-            return true;
+    void setElement(const std::vector<size_t>& indices, const Variable& v) {
+        setPhysical(flattenIndex(indices), v);
+    }
+
+    size_t getArraySize() const {
+        if (!dims.empty()) {
+            return dims[0];
         }
+        return 0;
+    }
 
-        
-        if (ip + 4 < tokens.size() &&
-            tokens[ip+1].type == TokenType::IDENTIFIER &&
-            tokens[ip+2].type == TokenType::ASSIGN) {
-            size_t exprStart = ip + 3;
-            size_t exprEnd = exprStart;
-            while (exprEnd < tokens.size() && tokens[exprEnd].type != TokenType::SEMICOLON) {
-                exprEnd++;
-            }
-            if (exprEnd < tokens.size() && tokens[exprEnd].type == TokenType::SEMICOLON) {
-                std::vector<Token> exprTokens(tokens.begin() + exprStart,
-                                             tokens.begin() + exprEnd);
-                VarType type = VarType::DOUBLE;
-                if (declType == TokenType::CREATE_INT) type = VarType::INT;
-                else if (declType == TokenType::CREATE_DOUBLE) type = VarType::DOUBLE;
-                else if (declType == TokenType::CREATE_OMNI) type = VarType::OMNI;
-                else if (declType == TokenType::CREATE_STRING) type = VarType::STRING;
+    const double* numericData(std::vector<double>& scratch) const {
+        if (store->numeric && !store->sparse && isContiguous()) return store->nums.data() + offset;
+        scratch.resize(elementCount());
+        forEachIndex([&](size_t i, size_t phys) { scratch[i] = store->numberAt(phys); });
+        return scratch.data();
+    }
 
-                if (type == VarType::STRING) {
-                    error(filename, tokens[ip].line, tokens[ip].col,
-                          "字符串类型不支持表达式赋值");
-                } else {
-                    size_t idx = 0;
-                    double result = evaluateExpr(exprTokens, idx);
-                    setVar(tokens[ip+1].lexeme, type, doubleToString(result));
-                }
-                ip = exprEnd + 1;
-                return true;
-            }
+    bool isSparse() const {
+        return store && store->sparse && !isView();
+    }
+
+    const double* foldedData(std::vector<double>& scratch, size_t& n) const {
+        if (!isSparse()) {
+            n = elementCount();
+            return numericData(scratch);
         }
-        return false;
+        scratch.clear();
+        scratch.reserve(store->cells.size() + 1);
+        for (const auto& cell : store->cells) scratch.push_back(cell.second);
+        if (scratch.size() < elementCount()) scratch.push_back(0.0);
+        n = scratch.size();
+        return scratch.data();
     }
 
-    
-    bool parseAssignment(const std::vector<Token>& tokens, size_t& ip) {
-        if (parseVariableDeclaration(tokens, ip)) {
-            return true;
+    Variable clone() const {
+        Variable copy = *this;
+        if (!store) return copy;
+        copy.records.reset();
+        if (!isView()) {
+            copy.store = std::make_shared<ArrayStore>(*store);
+            return copy;
+        }
+        copy.setDims(dims);
+        if (store->numeric) {
+            double* out = copy.store->nums.data();
+            forEachIndex([&](size_t i, size_t phys) { out[i] = store->numberAt(phys); });
+        } else {
+            copy.store->toText();
+            forEachIndex([&](size_t i, size_t phys) { copy.store->texts[i] = store->texts[phys]; });
         }
+        return copy;
+    }
 
-        
-        if (tokens[ip].type == TokenType::IDENTIFIER) {
-            size_t startIp = ip;
-            std::string arrayName = tokens[ip].lexeme;
-            ip++;
+    void assignFrom(const Variable& src) {
+        if (src.elementCount() != elementCount()) {
+            throw std::runtime_error("数组元素数量不一致");
+        }
+        Variable snapshot = src.store == store ? src.clone() : src;
+        if (!snapshot.store->numeric) store->toText();
+        std::vector<size_t> from(elementCount());
+        snapshot.forEachIndex([&](size_t i, size_t phys) { from[i] = phys; });
+        forEachIndex([&](size_t i, size_t phys) {
+            if (store->numeric) store->setNumber(phys, snapshot.store->numberAt(from[i]));
+            else store->texts[phys] = snapshot.store->textAt(from[i]);
+        });
+    }
 
-            std::vector<size_t> indices;
-            bool isArrayAccess = false;
+    void fill(const Variable& v) {
+        forEachIndex([&](size_t, size_t phys) { setPhysical(phys, v); });
+    }
 
-            while (ip < tokens.size() && tokens[ip].type == TokenType::LBRACKET) {
-                isArrayAccess = true;
-                ip++;
+    std::string arrayToString() const {
+        if (dims.empty() || !store) return "[]";
+        return multidimensionalToString(0, offset);
+    }
 
-                size_t exprEnd = ip;
-                while (exprEnd < tokens.size() && tokens[exprEnd].type != TokenType::RBRACKET) {
-                    exprEnd++;
-                }
-                if (exprEnd >= tokens.size() || tokens[exprEnd].type != TokenType::RBRACKET) {
-                    ip = startIp;
-                    break;
-                }
+    std::string dictToString() const {
+        std::string result = "{";
+        bool first = true;
+        dict->forEach([&](const DictKey& k, const DictKey& v) {
+            if (!first) result += ", ";
+            first = false;
+            result += k.toString() + ": " + v.toString();
+        });
+        return result + "}";
+    }
 
-                std::vector<Token> indexExpr(tokens.begin() + ip, tokens.begin() + exprEnd);
-                size_t idx = 0;
-                double indexValue = evaluateExpr(indexExpr, idx);
+    std::string recordToString() const {
+        if (dims.empty()) return records->rowToString(offset);
+        std::string r = "[";
+        for (size_t i = 0; i < dims[0]; ++i) {
+            if (i > 0) r += ", ";
+            r += records->rowToString(i);
+        }
+        return r + "]";
+    }
 
-                if (indexValue < 0 || indexValue != static_cast<long long>(indexValue)) {
-                    error(filename, tokens[ip].line, tokens[ip].col, "数组索引必须是正整数");
-                }
+    std::string heapToString() const {
+        std::string r = "[";
+        for (size_t i = 0; i < heap->keys.size(); ++i) {
+            if (i > 0) r += ", ";
+            r += formatNumber(heap->keys[i]);
+            if (heap->hasPayload) r += ": " + formatNumber(heap->payloads[i]);
+        }
+        return r + "]";
+    }
 
-                indices.push_back(static_cast<size_t>(indexValue));
-                ip = exprEnd + 1;
+    std::string displayString() const {
+        if (isArray()) return arrayToString();
+        if (isDict()) return dictToString();
+        if (isRecord()) return recordToString();
+        if (isHeap()) return heapToString();
+        if (isIndex()) return "sortedindex(" + std::to_string(sorted->size()) + ")";
+        if (isDigest()) return "tdigest(" + formatNumber(digest->count()) + ")";
+        if (isCsv()) return "csv(" + csv->path + ")";
+        return value;
+    }
+
+
+    
+    void sort(const SortOptions& opt = SortOptions()) {
+        if (!isArray()) {
+            throw std::runtime_error("sort()只能用于数组");
+        }
+        store->densify();
+        if (isContiguous()) {
+            if (store->numeric) sortDoubles(store->nums.data() + offset, elementCount(), opt);
+            else sortStrings(store->texts.data() + offset, elementCount(), opt.descending);
+            return;
+        }
+        Variable packed = clone();
+        packed.sort(opt);
+        assignFrom(packed);
+    }
+
+    
+    void sortAxis(size_t axis, const SortOptions& opt = SortOptions()) {
+        if (!isArray()) {
+            throw std::runtime_error("sort()只能用于数组");
+        }
+        if (axis >= dims.size()) {
+            throw std::runtime_error("排序轴超出数组维度");
+        }
+        store->densify();
+        size_t len = dims[axis];
+        size_t stride = strides[axis];
+        std::vector<size_t> laneShape = dims;
+        laneShape[axis] = 1;
+        std::vector<size_t> bases;
+        forEachIndexOf(laneShape, strides, offset, [&](size_t, size_t phys) { bases.push_back(phys); });
+        if (len < 2 || bases.empty()) return;
+        size_t chunks = std::min(chunkCount(bases.size() * len), bases.size());
+        parallelChunks(bases.size(), chunks, [&](size_t, size_t b, size_t e) {
+            std::vector<double> laneNums;
+            std::vector<std::string> laneTexts;
+            for (size_t lane = b; lane < e; ++lane) {
+                size_t base = bases[lane];
+                if (store->numeric && stride == 1) {
+                    sortDoubles(store->nums.data() + base, len, opt, false);
+                } else if (store->numeric) {
+                    laneNums.resize(len);
+                    for (size_t i = 0; i < len; ++i) laneNums[i] = store->nums[base + i * stride];
+                    sortDoubles(laneNums.data(), len, opt, false);
+                    for (size_t i = 0; i < len; ++i) store->nums[base + i * stride] = laneNums[i];
+                } else {
+                    laneTexts.resize(len);
+                    for (size_t i = 0; i < len; ++i) laneTexts[i] = std::move(store->texts[base + i * stride]);
+                    sortStrings(laneTexts.data(), len, opt.descending);
+                    for (size_t i = 0; i < len; ++i) store->texts[base + i * stride] = std::move(laneTexts[i]);
+                }
             }
+        });
+    }
 
-            if (isArrayAccess) {
-                if (ip < tokens.size() && tokens[ip].type == TokenType::ASSIGN) {
-                    ip++;
+    
+    double sum(SumMode mode = SumMode::FAST) const {
+        if (!isArray()) {
+            throw std::runtime_error("sum()只能用于数组");
+        }
+        if (elementCount() == 0) return 0.0;
+        std::vector<double> scratch;
+        if (store->sparse && !isView()) {
+            scratch.reserve(store->cells.size());
+            for (const auto& cell : store->cells) scratch.push_back(cell.second);
+            return reduceSum(scratch.data(), scratch.size(), mode);
+        }
+        return reduceSum(numericData(scratch), elementCount(), mode);
+    }
 
-                    size_t valueStart = ip;
-                    size_t valueEnd = valueStart;
-                    while (valueEnd < tokens.size() && tokens[valueEnd].type != TokenType::SEMICOLON) {
-                        valueEnd++;
-                    }
+    
+    int find(const std::string& substr) const {
+        if (type != VarType::STRING) {
+            throw std::runtime_error("find()只能用于字符串");
+        }
+        size_t pos = value.find(substr);
+        return (pos == std::string::npos) ? -1 : static_cast<int>(pos);
+    }
+private:
+    
+    std::string multidimensionalToString(size_t dimIdx, size_t phys) const {
+        std::string r = "[";
+        for (size_t i = 0; i < dims[dimIdx]; ++i) {
+            if (i > 0) r += ", ";
+            if (dimIdx == dims.size() - 1) r += store->textAt(phys + i * strides[dimIdx]);
+            else r += multidimensionalToString(dimIdx + 1, phys + i * strides[dimIdx]);
+        }
+        r += "]";
+        return r;
+    }
+};
 
-                    if (valueEnd < tokens.size() && tokens[valueEnd].type == TokenType::SEMICOLON) {
-                        std::vector<Token> valueTokens(tokens.begin() + valueStart, tokens.begin() + valueEnd);
+struct StringSink {
+    std::string& out;
 
-                        auto it = vars.find(arrayName);
-                        if (it == vars.end()) {
-                            error(filename, tokens[startIp].line, tokens[startIp].col, "未声明的数组");
-                        }
+    void write(const char* p, size_t n) {
+        out.append(p, n);
+    }
 
-                        Variable val(VarType::OMNI);
-                        if (valueTokens.size() == 1) {
-                            if (valueTokens[0].type == TokenType::NUMBER) {
-                                val.value = valueTokens[0].lexeme;
-                            } else if (valueTokens[0].type == TokenType::STRING) {
-                                val.value = valueTokens[0].lexeme;
-                            } else if (valueTokens[0].type == TokenType::IDENTIFIER) {
-                                if (!hasVar(valueTokens[0].lexeme)) {
-                                    error(filename, valueTokens[0].line, valueTokens[0].col,
-                                          "赋值时右侧变量 \'" + valueTokens[0].lexeme + "\' 未声明");
-                                }
-                                val.value = getVar(valueTokens[0].lexeme);
-                            }
-                        } else {
-                            size_t exprIdx = 0;
-                            double result = evaluateExpr(valueTokens, exprIdx);
-                            val.value = doubleToString(result);
-                        }
+    void put(char c) {
+        out.push_back(c);
+    }
+};
 
-                        if (!it->second.dims.empty()) {
-                            if (indices.size() != it->second.dims.size()) {
-                                error(filename, tokens[startIp].line, tokens[startIp].col, "维度不匹配");
-                            }
-                            it->second.getElement(indices) = val;
-                            if (indices.size() == 1 && indices[0] == 0) {
-                                it->second.value = val.value;
-                            }
-                        } else {
-                            setArrayElement(arrayName, indices[0], val);
-                        }
+template <typename Sink>
+void writeJsonNumber(Sink& sink, double v) {
+    if (!std::isfinite(v)) {
+        sink.write("null", 4);
+        return;
+    }
+    char buf[NUMBER_CHARS];
+    sink.write(buf, static_cast<size_t>(formatNumberTo(buf, buf + sizeof(buf), v) - buf));
+}
 
-                        ip = valueEnd + 1;
-                        return true;
-                    }
-                }
-                ip = startIp;
-            }
+template <typename Sink>
+void writeJsonString(Sink& sink, const std::string& text) {
+    static const char HEX[] = "0123456789abcdef";
+    sink.put('"');
+    const char* p = text.data();
+    const char* end = p + text.size();
+    const char* run = p;
+    for (; p < end; ++p) {
+        unsigned char c = static_cast<unsigned char>(*p);
+        if (c >= 0x20 && c != '"' && c != '\\') continue;
+        sink.write(run, static_cast<size_t>(p - run));
+        run = p + 1;
+        switch (c) {
+        case '"': sink.write("\\\"", 2); break;
+        case '\\': sink.write("\\\\", 2); break;
+        case '\n': sink.write("\\n", 2); break;
+        case '\r': sink.write("\\r", 2); break;
+        case '\t': sink.write("\\t", 2); break;
+        case '\b': sink.write("\\b", 2); break;
+        case '\f': sink.write("\\f", 2); break;
+        default: {
+            char esc[6] = {'\\', 'u', '0', '0', HEX[c >> 4], HEX[c & 15]};
+            sink.write(esc, sizeof(esc));
         }
+        }
+    }
+    sink.write(run, static_cast<size_t>(end - run));
+    sink.put('"');
+}
 
-        
-        
-        if (tokens[ip].type == TokenType::IDENTIFIER && ip + 3 < tokens.size() &&
-            tokens[ip+1].type == TokenType::ASSIGN &&
-            tokens[ip+3].type == TokenType::SEMICOLON) {
+template <typename Sink>
+void writeJsonScalar(Sink& sink, const std::string& text, bool numeric) {
+    double v = 0;
+    if (numeric && parseNumber(text, v)) writeJsonNumber(sink, v);
+    else writeJsonString(sink, text);
+}
 
-            std::string leftName = tokens[ip].lexeme;
-            const Token& rightToken = tokens[ip+2];
+template <typename Sink>
+void writeJsonKey(Sink& sink, const DictKey& k) {
+    if (k.numeric) {
+        sink.put('"');
+        writeJsonNumber(sink, k.num);
+        sink.put('"');
+    } else {
+        writeJsonString(sink, k.text);
+    }
+}
 
-            
-            if (!hasVar(leftName)) {
-                error(filename, tokens[ip].line, tokens[ip].col,
-                      "变量 \'" + leftName + "\' 未声明，不能赋值");
-            }
+template <typename Sink>
+void writeJsonCell(Sink& sink, const ArrayStore& store, size_t phys) {
+    if (store.sparse) writeJsonNumber(sink, store.sparseAt(phys));
+    else if (store.numeric) writeJsonNumber(sink, store.nums[phys]);
+    else writeJsonString(sink, store.texts[phys]);
+}
 
-            
-            if (rightToken.type == TokenType::NUMBER) {
-                std::string val = rightToken.lexeme;
-                VarType type = getVarType(leftName);
-                setVar(leftName, type, val);
-                ip += 4;
-                return true;
-            }
+template <typename Sink>
+void writeJsonArray(Sink& sink, const Variable& v, size_t dimIdx, size_t phys) {
+    sink.put('[');
+    for (size_t i = 0; i < v.dims[dimIdx]; ++i) {
+        if (i > 0) sink.put(',');
+        if (dimIdx == v.dims.size() - 1) writeJsonCell(sink, *v.store, phys + i * v.strides[dimIdx]);
+        else writeJsonArray(sink, v, dimIdx + 1, phys + i * v.strides[dimIdx]);
+    }
+    sink.put(']');
+}
 
-            
-            if (rightToken.type == TokenType::STRING) {
-                std::string val = rightToken.lexeme;
-                VarType type = getVarType(leftName);
-                setVar(leftName, type, val);
-                ip += 4;
-                return true;
+template <typename Sink>
+void writeJsonRow(Sink& sink, const RecordStore& records, size_t row) {
+    sink.put('{');
+    for (size_t f = 0; f < records.columns.size(); ++f) {
+        if (f > 0) sink.put(',');
+        writeJsonString(sink, records.layout->fields[f]);
+        sink.put(':');
+        writeJsonCell(sink, *records.columns[f], row);
+    }
+    sink.put('}');
+}
+
+template <typename Sink>
+bool writeJson(Sink& sink, const Variable& v) {
+    if (v.isArray()) {
+        writeJsonArray(sink, v, 0, v.offset);
+    } else if (v.isDict()) {
+        sink.put('{');
+        bool first = true;
+        v.dict->forEach([&](const DictKey& k, const DictKey& val) {
+            if (!first) sink.put(',');
+            first = false;
+            writeJsonKey(sink, k);
+            sink.put(':');
+            if (val.numeric) writeJsonNumber(sink, val.num);
+            else writeJsonString(sink, val.text);
+        });
+        sink.put('}');
+    } else if (v.isRecord()) {
+        if (v.dims.empty()) {
+            writeJsonRow(sink, *v.records, v.offset);
+        } else {
+            sink.put('[');
+            for (size_t i = 0; i < v.dims[0]; ++i) {
+                if (i > 0) sink.put(',');
+                writeJsonRow(sink, *v.records, i);
             }
+            sink.put(']');
+        }
+    } else if (v.isContainer()) {
+        return false;
+    } else {
+        writeJsonScalar(sink, v.value, v.type != VarType::STRING);
+    }
+    return true;
+}
 
-            
-            if (rightToken.type == TokenType::IDENTIFIER) {
-                std::string rightName = rightToken.lexeme;
-                if (!hasVar(rightName)) {
-                    error(filename, rightToken.line, rightToken.col,
-                          "赋值时右侧变量 \'" + rightName + "\' 未声明");
-                }
-                Variable rightVar = vars[rightName];
-                VarType leftType = getVarType(leftName);
-                setVar(leftName, leftType, rightVar.value);
-                ip += 4;
-                return true;
-            }
+struct JsonParser {
+    static constexpr size_t MAX_DEPTH = 64;
+
+    const char* begin;
+    const char* p;
+    const char* end;
+    std::string problem;
+
+    JsonParser(const char* first, const char* last) : begin(first), p(first), end(last) {}
+
+    bool fail(const std::string& msg) {
+        if (problem.empty()) problem = msg + "（第 " + std::to_string(p - begin) + " 字节）";
+        return false;
+    }
+
+    void skip() {
+        while (p < end && (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t')) ++p;
+    }
+
+    bool expect(char c) {
+        skip();
+        if (p >= end || *p != c) return fail(std::string("此处应为 \'") + c + "\'");
+        ++p;
+        return true;
+    }
+
+    bool parseDocument(Variable& out) {
+        if (!parseValue(out)) return false;
+        skip();
+        if (p != end) return fail("JSON 末尾有多余内容");
+        return true;
+    }
+
+    bool parseValue(Variable& out) {
+        skip();
+        if (p >= end) return fail("JSON 意外结束");
+        if (*p == '{') return parseObject(out);
+        if (*p == '[') return parseArray(out);
+        std::string text;
+        bool isText = false;
+        if (!parseScalar(text, isText)) return false;
+        out = Variable(isText ? VarType::STRING : VarType::DOUBLE, text);
+        return true;
+    }
+
+    bool parseScalar(std::string& text, bool& isText) {
+        skip();
+        if (p >= end) return fail("JSON 意外结束");
+        isText = *p == '"';
+        if (isText) return parseString(text);
+        if (matchWord("true")) text = "1";
+        else if (matchWord("false") || matchWord("null")) text = "0";
+        else if (*p == '-' || isdigit(static_cast<unsigned char>(*p))) {
+            double v = 0;
+            const char* first = p;
+            if (!readNumber(v)) return false;
+            if (std::isinf(v)) text = formatNumber(v);
+            else text.assign(first, p);
+        } else {
+            return fail("无效的 JSON 值");
         }
+        return true;
+    }
 
-        
-        if (tokens[ip].type == TokenType::IDENTIFIER && ip + 2 < tokens.size() &&
-            tokens[ip+1].type == TokenType::ASSIGN) {
-            size_t exprStart = ip + 2;
-            size_t exprEnd = exprStart;
-            while (exprEnd < tokens.size() && tokens[exprEnd].type != TokenType::SEMICOLON) {
-                exprEnd++;
-            }
-            if (exprEnd < tokens.size() && tokens[exprEnd].type == TokenType::SEMICOLON) {
-                std::vector<Token> exprTokens(tokens.begin() + exprStart,
-                                             tokens.begin() + exprEnd);
-                std::string name = tokens[ip].lexeme;
-                if (!hasVar(name)) {
-                    error(filename, tokens[ip].line, tokens[ip].col,
-                          "变量 \'" + name + "\' 未声明，不能赋值表达式");
-                }
-                VarType type = getVarType(name);
-                if (type == VarType::STRING) {
-                    error(filename, tokens[ip].line, tokens[ip].col,
-                          "字符串类型不支持表达式赋值");
-                } else {
-                    size_t idx = 0;
-                    double result = evaluateExpr(exprTokens, idx);
-                    setVar(name, type, doubleToString(result));
-                }
-                ip = exprEnd + 1;
-                return true;
-            }
+    bool readNumber(double& v) {
+        const char* q = p;
+        auto digits = [&]() {
+            const char* from = q;
+            while (q < end && isdigit(static_cast<unsigned char>(*q))) ++q;
+            return q != from;
+        };
+        if (q < end && *q == '-') ++q;
+        if (q < end && *q == '0') ++q;
+        else if (!digits()) return fail("无效的数字");
+        if (q < end && *q == '.') {
+            ++q;
+            if (!digits()) return fail("无效的数字");
         }
+        if (q < end && (*q == 'e' || *q == 'E')) {
+            ++q;
+            if (q < end && (*q == '+' || *q == '-')) ++q;
+            if (!digits()) return fail("无效的数字");
+        }
+        auto res = std::from_chars(p, q, v);
+        if (res.ec == std::errc::result_out_of_range) {
+            v = strtod(std::string(p, q).c_str(), nullptr);
+        } else if (res.ec != std::errc() || res.ptr != q) {
+            return fail("无效的数字");
+        }
+        p = q;
+        return true;
+    }
 
-        
-        if (tokens[ip].type == TokenType::IDENTIFIER && ip + 3 < tokens.size() &&
-            (tokens[ip+1].type == TokenType::PLUS_EQUALS ||
-             tokens[ip+1].type == TokenType::MINUS_EQUALS ||
-             tokens[ip+1].type == TokenType::STAR_EQUALS ||
-             tokens[ip+1].type == TokenType::SLASH_EQUALS) &&
-            (tokens[ip+2].type == TokenType::NUMBER ||
-             tokens[ip+2].type == TokenType::IDENTIFIER) &&
-            tokens[ip+3].type == TokenType::SEMICOLON) {
-            std::string varName = tokens[ip].lexeme;
-            if (!hasVar(varName)) {
-                error(filename, tokens[ip].line, tokens[ip].col,
-                      "变量 \'" + varName + "\' 未声明");
-            }
-            std::string op = tokens[ip+1].lexeme;
-            op = op.substr(0, 1);
-            double rightVal = 0;
-            if (tokens[ip+2].type == TokenType::NUMBER) {
-                rightVal = stringToDouble(tokens[ip+2].lexeme);
-            } else {
-                if (!hasVar(tokens[ip+2].lexeme)) {
-                    error(filename, tokens[ip+2].line, tokens[ip+2].col,
-                          "变量 \'" + tokens[ip+2].lexeme + "\' 未声明");
-                }
-                rightVal = getNumericVar(tokens[ip+2].lexeme);
-            }
-            double currentVal = getNumericVar(varName);
-            double result = performArithmeticOp(currentVal, op, rightVal);
-            VarType type = getVarType(varName);
-            setVar(varName, type, doubleToString(result));
-            ip += 4;
+    bool parseNumberValue(double& v, bool& isNumber, std::string& text) {
+        skip();
+        if (p < end && (*p == '-' || isdigit(static_cast<unsigned char>(*p)))) {
+            if (!readNumber(v)) return false;
+            isNumber = true;
             return true;
         }
+        bool isText = false;
+        isNumber = false;
+        if (!parseScalar(text, isText)) return false;
+        if (!isText) {
+            isNumber = true;
+            v = text == "1" ? 1 : 0;
+        }
+        return true;
+    }
 
-        
-        if (tokens[ip].type == TokenType::IDENTIFIER && ip + 2 < tokens.size() &&
-            (tokens[ip+1].type == TokenType::PLUS_PLUS ||
-             tokens[ip+1].type == TokenType::MINUS_MINUS) &&
-            tokens[ip+2].type == TokenType::SEMICOLON) {
-            std::string varName = tokens[ip].lexeme;
-            if (!hasVar(varName)) {
-                error(filename, tokens[ip].line, tokens[ip].col,
-                      "变量 \'" + varName + "\' 未声明");
+    bool matchWord(const char* word) {
+        size_t n = strlen(word);
+        if (static_cast<size_t>(end - p) < n || memcmp(p, word, n) != 0) return false;
+        p += n;
+        return true;
+    }
+
+    bool parseString(std::string& out) {
+        ++p;
+        const char* q = static_cast<const char*>(memchr(p, '"', end - p));
+        if (!q) return fail("字符串没有闭合");
+        if (!memchr(p, '\\', q - p)) {
+            out.assign(p, q);
+            p = q + 1;
+            return true;
+        }
+        out.clear();
+        while (p < end) {
+            char c = *p++;
+            if (c == '"') return true;
+            if (c != '\\') {
+                out.push_back(c);
+                continue;
             }
-            double currentVal = getNumericVar(varName);
-            double result = currentVal;
-            if (tokens[ip+1].type == TokenType::PLUS_PLUS) {
-                result = currentVal + 1;
-            } else {
-                result = currentVal - 1;
+            if (p >= end) break;
+            char e = *p++;
+            switch (e) {
+            case '"': out.push_back('"'); break;
+            case '\\': out.push_back('\\'); break;
+            case '/': out.push_back('/'); break;
+            case 'b': out.push_back('\b'); break;
+            case 'f': out.push_back('\f'); break;
+            case 'n': out.push_back('\n'); break;
+            case 'r': out.push_back('\r'); break;
+            case 't': out.push_back('\t'); break;
+            case 'u': {
+                uint32_t cp = 0;
+                if (!parseHex4(cp)) return false;
+                if (cp >= 0xD800 && cp < 0xDC00) {
+                    const char* mark = p;
+                    uint32_t low = 0;
+                    if (end - p >= 6 && p[0] == '\\' && p[1] == 'u') {
+                        p += 2;
+                        if (!parseHex4(low)) return false;
+                    }
+                    if (low >= 0xDC00 && low < 0xE000) {
+                        cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                    } else {
+                        cp = 0xFFFD;
+                        p = mark;
+                    }
+                } else if (cp >= 0xDC00 && cp < 0xE000) {
+                    cp = 0xFFFD;
+                }
+                appendUtf8(out, cp);
+                break;
+            }
+            default:
+                return fail("无效的转义字符");
             }
-            VarType type = getVarType(varName);
-            setVar(varName, type, doubleToString(result));
-            ip += 3;
-            return true;
         }
-        return false;
+        return fail("字符串没有闭合");
     }
 
-    
-    std::vector<std::string> parseFunctionArguments(const std::vector<Token>& tokens, size_t& ip) {
-        std::vector<std::string> args;
+    bool parseHex4(uint32_t& cp) {
+        if (end - p < 4) return fail("\\u 转义不完整");
+        auto res = std::from_chars(p, p + 4, cp, 16);
+        if (res.ec != std::errc() || res.ptr != p + 4) return fail("\\u 转义不完整");
+        p += 4;
+        return true;
+    }
 
-        if (tokens[ip].type != TokenType::LPAREN) {
-            error(filename, tokens[ip].line, tokens[ip].col, "函数调用缺少 \'(\'");
+    static void appendUtf8(std::string& out, uint32_t cp) {
+        if (cp < 0x80) {
+            out.push_back(static_cast<char>(cp));
+        } else if (cp < 0x800) {
+            out.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+            out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        } else if (cp < 0x10000) {
+            out.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+            out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        } else {
+            out.push_back(static_cast<char>(0xF0 | (cp >> 18)));
+            out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
         }
-        ip++;
+    }
 
-        if (tokens[ip].type == TokenType::RPAREN) {
-            ip++;
-            return args;
+    bool parseObject(Variable& out) {
+        out = Variable(VarType::DICT, "");
+        out.dict = std::make_shared<DictStore>();
+        ++p;
+        skip();
+        if (p < end && *p == '}') {
+            ++p;
+            return true;
+        }
+        std::string keyText;
+        std::string valueText;
+        while (true) {
+            skip();
+            if (p >= end || *p != '"') return fail("对象的键必须是字符串");
+            if (!parseString(keyText) || !expect(':')) return false;
+            skip();
+            if (p < end && (*p == '{' || *p == '[')) return fail("字典的值只能是数字或字符串，不支持嵌套");
+            DictKey key;
+            key.numeric = parseNumber(keyText, key.num);
+            if (!key.numeric) key.text = keyText;
+            DictKey& slot = out.dict->insert(key);
+            bool isNumber = false;
+            if (!parseNumberValue(slot.num, isNumber, valueText)) return false;
+            slot.numeric = isNumber;
+            if (!isNumber) slot.text = valueText;
+            skip();
+            if (p < end && *p == ',') {
+                ++p;
+                continue;
+            }
+            return expect('}');
         }
+    }
 
-        while (ip < tokens.size()) {
-            if (tokens[ip].type == TokenType::NUMBER) {
-                args.push_back(tokens[ip].lexeme);
-                ip++;
-            } else if (tokens[ip].type == TokenType::STRING) {
-                args.push_back(tokens[ip].lexeme);
-                ip++;
-            } else if (tokens[ip].type == TokenType::IDENTIFIER) {
-                if (!hasVar(tokens[ip].lexeme)) {
-                    error(filename, tokens[ip].line, tokens[ip].col,
-                          "函数参数变量 \'" + tokens[ip].lexeme + "\' 未声明");
+    struct ArrayBuild {
+        std::vector<size_t> shape;
+        size_t leafDepth = SIZE_MAX;
+        std::shared_ptr<ArrayStore> store = std::make_shared<ArrayStore>();
+        std::string text;
+    };
+
+    bool parseArray(Variable& out) {
+        const char* start = p;
+        ++p;
+        skip();
+        if (p < end && *p == '{') {
+            p = start;
+            return parseRecords(out);
+        }
+        p = start;
+        ArrayBuild build;
+        if (!parseLevel(build, 0)) return false;
+        for (size_t& d : build.shape) {
+            if (d == SIZE_MAX) d = 0;
+        }
+        if (build.leafDepth != SIZE_MAX && build.leafDepth + 1 != build.shape.size()) {
+            return fail("数组嵌套层次不一致");
+        }
+        out = Variable(VarType::ARRAY, "");
+        out.dims = build.shape;
+        out.strides = Variable::rowMajorStrides(out.dims);
+        out.store = build.store;
+        return true;
+    }
+
+    bool parseLevel(ArrayBuild& b, size_t depth) {
+        if (depth >= MAX_DEPTH) return fail("数组嵌套超过 " + std::to_string(MAX_DEPTH) + " 层");
+        ++p;
+        size_t count = 0;
+        skip();
+        if (p < end && *p == ']') {
+            ++p;
+        } else {
+            while (true) {
+                skip();
+                if (p >= end) return fail("数组没有闭合");
+                if (*p == '[') {
+                    if (b.leafDepth != SIZE_MAX && b.leafDepth <= depth) return fail("数组嵌套层次不一致");
+                    if (!parseLevel(b, depth + 1)) return false;
+                } else if (*p == '{') {
+                    return fail("对象只能出现在最外层数组中");
+                } else {
+                    if (b.leafDepth == SIZE_MAX) b.leafDepth = depth;
+                    else if (b.leafDepth != depth) return fail("数组嵌套层次不一致");
+                    if (!parseElement(b)) return false;
                 }
-                args.push_back(getVar(tokens[ip].lexeme));
-                ip++;
-            } else {
-                error(filename, tokens[ip].line, tokens[ip].col, "函数参数必须是数字、字符串或变量");
+                count++;
+                skip();
+                if (p < end && *p == ',') {
+                    ++p;
+                    continue;
+                }
+                if (!expect(']')) return false;
+                break;
             }
+        }
+        if (b.shape.size() <= depth) b.shape.resize(depth + 1, SIZE_MAX);
+        if (b.shape[depth] == SIZE_MAX) b.shape[depth] = count;
+        else if (b.shape[depth] != count) return fail("数组不是规则的矩形");
+        return true;
+    }
 
-            if (tokens[ip].type == TokenType::COMMA) {
-                ip++;
-            } else if (tokens[ip].type == TokenType::RPAREN) {
-                ip++;
-                break;
+    bool parseElement(ArrayBuild& b) {
+        ArrayStore& store = *b.store;
+        double v = 0;
+        bool isNumber = false;
+        const char* first = p;
+        if (!parseNumberValue(v, isNumber, b.text)) return false;
+        if (isNumber && store.numeric) {
+            store.nums.push_back(v);
+        } else {
+            store.toText();
+            if (isNumber && *first != '"') {
+                const char* s = first;
+                while (s < p && (*s == ' ' || *s == '\n' || *s == '\r' || *s == '\t')) ++s;
+                if (*s == 't' || *s == 'f' || *s == 'n') store.texts.push_back(v == 1 ? "1" : "0");
+                else store.texts.emplace_back(s, p);
             } else {
-                error(filename, tokens[ip].line, tokens[ip].col, "函数参数列表缺少 \',\' 或 \')\'");
+                store.texts.push_back(b.text);
             }
         }
-
-        return args;
+        return true;
     }
 
-    
-    void callFunction(const std::string& funcName, const std::vector<std::string>& args, size_t& ip) {
-        auto it = functions.find(funcName);
-        if (it == functions.end()) {
-            error(filename, 0, 0, "未定义的函数 \'" + funcName + "\'");
+    bool parseRecords(Variable& out) {
+        auto layout = std::make_shared<RecordLayout>();
+        layout->name = "json";
+        std::vector<std::shared_ptr<ArrayStore>> columns;
+        std::vector<char> seen;
+        std::string keyText;
+        std::string valueText;
+        size_t rows = 0;
+        ++p;
+        while (true) {
+            if (!expect('{')) return false;
+            std::fill(seen.begin(), seen.end(), 0);
+            skip();
+            if (p < end && *p == '}') {
+                ++p;
+            } else {
+                while (true) {
+                    skip();
+                    if (p >= end || *p != '"') return fail("对象的键必须是字符串");
+                    if (!parseString(keyText) || !expect(':')) return false;
+                    size_t slot = std::find(layout->fields.begin(), layout->fields.end(), keyText) - layout->fields.begin();
+                    if (slot == layout->fields.size()) {
+                        if (rows > 0) return fail("对象的字段 \'" + keyText + "\' 不在第一个对象中");
+                        layout->fields.push_back(keyText);
+                        columns.push_back(std::make_shared<ArrayStore>());
+                        seen.push_back(0);
+                    }
+                    if (seen[slot]) return fail("对象的字段 \'" + keyText + "\' 重复");
+                    seen[slot] = 1;
+                    skip();
+                    if (p < end && (*p == '{' || *p == '[')) return fail("记录字段只能保存数字或字符串");
+                    double v = 0;
+                    bool isNumber = false;
+                    if (!parseNumberValue(v, isNumber, valueText)) return false;
+                    ArrayStore& col = *columns[slot];
+                    if (isNumber && col.numeric) {
+                        col.nums.push_back(v);
+                    } else {
+                        col.toText();
+                        col.texts.push_back(isNumber ? formatNumber(v) : valueText);
+                    }
+                    skip();
+                    if (p < end && *p == ',') {
+                        ++p;
+                        continue;
+                    }
+                    if (!expect('}')) return false;
+                    break;
+                }
+            }
+            for (size_t f = 0; f < columns.size(); ++f) {
+                if (seen[f]) continue;
+                if (columns[f]->numeric) columns[f]->nums.push_back(0);
+                else columns[f]->texts.emplace_back();
+            }
+            rows++;
+            skip();
+            if (p < end && *p == ',') {
+                ++p;
+                continue;
+            }
+            if (!expect(']')) return false;
+            break;
         }
+        if (layout->fields.empty()) return fail("记录数组中的对象至少需要一个字段");
+        auto store = std::make_shared<RecordStore>(layout, 0);
+        store->count = rows;
+        store->columns = std::move(columns);
+        out = Variable(VarType::RECORD, "");
+        out.dims = {rows};
+        out.records = store;
+        return true;
+    }
+};
 
-        Function& func = it->second;
-
-        callStack.push(vars);
-        vars.clear();
 
-        std::string allArgs;
-        for (size_t i = 0; i < args.size(); ++i) {
-            if (i > 0) allArgs += ",";
-            allArgs += args[i];
-        }
+struct Function {
+    std::string name;
+    std::vector<Token> body;
+    std::vector<std::string> paramNames;
+    bool hasReturnValue;
 
-        if (!allArgs.empty()) {
-            vars["_args"] = Variable(VarType::STRING, allArgs);
-        }
+    Function(const std::string& n = "", const std::vector<Token>& b = {}, 
+             bool ret = false) 
+        : name(n), body(b), hasReturnValue(ret) {}
+};
 
-        execute(func.body);
 
-        vars = callStack.top();
-        callStack.pop();
-    }
+struct TimerState {
+    std::chrono::high_resolution_clock::time_point startTime;
+    bool isRunning;
+    double lastElapsedMs;
 
-    
-    void execute(const std::vector<Token>& tokens) {
-        size_t ip = 0;
-        while (ip < tokens.size()) {
-            const Token& t = tokens[ip];
+    TimerState() : isRunning(false), lastElapsedMs(0.0) {}
+};
 
-            if (t.type == TokenType::DTIME_TIC) {
-                timer.startTime = std::chrono::high_resolution_clock::now();
-                timer.isRunning = true;
-                hasTocExecuted = false;
-                ip++;
-                continue;
-            }
 
-            if (t.type == TokenType::DTIME_TOC) {
-                if (!timer.isRunning) {
-                    error(filename, t.line, t.col, "dtime_toc 必须在 dtime_tic 之后使用");
-                }
+struct Scanner {
+    std::string src;
+    std::string filename;
+    size_t pos = 0;
+    int line = 1;
+    int col = 1;
+    bool in_output_redirect = false;
+    bool in_create = false;
 
-                auto endTime = std::chrono::high_resolution_clock::now();
-                auto duration = std::chrono::duration_cast<std::chrono::microseconds>(endTime - timer.startTime);
-                lastTocTime = duration.count() / 1000.0;
-                timer.isRunning = false;
-                hasTocExecuted = true;
+    Scanner(const std::string& s, const std::string& fname)
+        : src(s), filename(fname) {}
 
-                ip++;
+    
+    bool match(const char* s) {
+        size_t n = std::strlen(s);
+        if (pos + n > src.length()) return false;
+        return src.compare(pos, n, s) == 0;
+    }
 
-                if (ip < tokens.size() && tokens[ip].type == TokenType::LPAREN) {
-                    ip++;
+    
+    void advance() {
+        if (pos < src.size()) {
+            if (src[pos] == '\n') {
+                line++;
+                col = 1;
+            } else {
+                col++;
+            }
+            pos++;
+        }
+    }
 
-                    if (ip < tokens.size() && tokens[ip].type == TokenType::IDENTIFIER) {
-                        std::string varName = tokens[ip].lexeme;
-                        ip++;
+    
+    void skipWhitespace() {
+        while (pos < src.size()) {
+            char c = src[pos];
+            if (c == ' ' || c == '\t' || c == '\r') {
+                col++;
+                pos++;
+            } else if (c == '\n') {
+                line++;
+                col = 1;
+                pos++;
+            } else {
+                break;
+            }
+        }
+    }
 
-                        if (ip < tokens.size() && tokens[ip].type == TokenType::RPAREN) {
-                            ip++;
+    
+    std::vector<Token> scan() {
+        std::vector<Token> tokens;
+        in_output_redirect = false;
+        in_create = false;
 
-                            if (ip < tokens.size() && tokens[ip].type == TokenType::SEMICOLON) {
-                                ip++;
-                                setVar(varName, VarType::DOUBLE, doubleToString(lastTocTime));
-                                continue;
-                            }
-                        }
-                    }
+        while (pos < src.size()) {
+            skipWhitespace();
+            if (pos >= src.size()) break;
 
-                    ip = ip - 1;
-                }
+            char c = src[pos];
 
-                if (ip < tokens.size() && tokens[ip].type == TokenType::LPAREN) {
-                    ip++;
-                    if (ip < tokens.size() && tokens[ip].type == TokenType::RPAREN) {
-                        ip++;
-                        if (ip < tokens.size() && tokens[ip].type == TokenType::SEMICOLON) {
-                            ip++;
-                        }
-                    }
-                }
+            if (match("dtime_tic")) {
+                tokens.emplace_back(TokenType::DTIME_TIC, "dtime_tic", line, col);
+                pos += 9;
+                col += 9;
                 continue;
             }
 
-            
-            if (t.type == TokenType::RANDOM) {
-                size_t startIp = ip;
-                ip++;  
-
-                double minVal = -1e9;
-                double maxVal = 1e9;
-                bool isIntRange = false;
-
-                if (ip < tokens.size() && tokens[ip].type == TokenType::DOT) {
-                    ip++;
-                    isIntRange = true;
-
-                    if (ip < tokens.size() && tokens[ip].type == TokenType::NUMBER) {
-                        minVal = stringToDouble(tokens[ip].lexeme);
-                        ip++;
-                    } else {
-                        error(filename, t.line, t.col, "random 范围语法错误: 缺少最小值");
-                    }
-
-                    if (ip < tokens.size() && tokens[ip].type == TokenType::TILDE) {
-                        ip++;
-                    } else {
-                        error(filename, t.line, t.col, "random 范围语法错误: 缺少 ~");
-                    }
-
-                    if (ip < tokens.size() && tokens[ip].type == TokenType::NUMBER) {
-                        maxVal = stringToDouble(tokens[ip].lexeme);
-                        ip++;
-                    } else {
-                        error(filename, t.line, t.col, "random 范围语法错误: 缺少最大值");
-                    }
-
-                    if (minVal > maxVal) {
-                        error(filename, t.line, t.col, "random 范围错误: 最小值不能大于最大值");
-                    }
-                }
-
-                if (ip < tokens.size() && tokens[ip].type == TokenType::LPAREN) {
-                    ip++;
-                } else {
-                    error(filename, t.line, t.col, "random 语法错误: 缺少 \'(\'");
-                }
-
-                std::string varName;
-                if (ip < tokens.size() && tokens[ip].type == TokenType::IDENTIFIER) {
-                    varName = tokens[ip].lexeme;
-                    ip++;
-                } else {
-                    error(filename, t.line, t.col, "random 语法错误: 括号内必须指定变量名");
-                }
-
-                if (ip < tokens.size() && tokens[ip].type == TokenType::RPAREN) {
-                    ip++;
-                } else {
-                    error(filename, t.line, t.col, "random 语法错误: 缺少 \')\'");
-                }
-
-                if (ip < tokens.size() && tokens[ip].type == TokenType::SEMICOLON) {
-                    ip++;
-                } else {
-                    error(filename, t.line, t.col, "random 语句必须加分号");
-                }
-
-                
-                if (!hasVar(varName)) {
-                    error(filename, tokens[ip-4].line, tokens[ip-4].col,  
-                          "变量 \'" + varName + "\' 未声明，random 目标必须已声明");
-                }
-
-                double randomValue;
-                if (isIntRange) {
-                    int imin = static_cast<int>(minVal);
-                    int imax = static_cast<int>(maxVal);
-                    std::uniform_int_distribution<int> dist(imin, imax);
-                    randomValue = dist(rng);
-                } else {
-                    std::uniform_real_distribution<double> dist(minVal, maxVal);
-                    randomValue = dist(rng);
-                }
-
-                VarType type = getVarType(varName);
-                setVar(varName, type, doubleToString(randomValue));
+            if (match("dtime_toc")) {
+                tokens.emplace_back(TokenType::DTIME_TOC, "dtime_toc", line, col);
+                pos += 9;
+                col += 9;
+                continue;
+            }
 
+            if (match("dtime()")) {
+                tokens.emplace_back(TokenType::DTIME_FUNC, "dtime()", line, col);
+                pos += 7;
+                col += 7;
                 continue;
             }
 
             
-            if (t.type == TokenType::CREATE && ip + 5 < tokens.size() &&
-                tokens[ip+1].type == TokenType::IDENTIFIER &&
-                tokens[ip+2].type == TokenType::LPAREN &&
-                tokens[ip+3].type == TokenType::FUNCTION &&
-                tokens[ip+4].type == TokenType::RPAREN &&
-                (tokens[ip+5].type == TokenType::FALID || 
-                 tokens[ip+5].type == TokenType::VALID)) {
-
-                std::string funcName = tokens[ip+1].lexeme;
-                bool hasReturn = (tokens[ip+5].type == TokenType::VALID);
+            if (match("random")) {
+                tokens.emplace_back(TokenType::RANDOM, "random", line, col);
+                pos += 6;
+                col += 6;
+                continue;
+            }
 
-                size_t bodyStart = ip + 6;
-                if (bodyStart >= tokens.size() || tokens[bodyStart].type != TokenType::LBRACE) {
-                    error(filename, t.line, t.col, "函数定义缺少 \'{\'");
+            if (c == '!') {
+                advance();
+                if (match("utilize")) {
+                    tokens.emplace_back(TokenType::UTILIZE, "!utilize", line, col - 1);
+                    pos += 7;
+                    col += 7;
+                } else {
+                    tokens.emplace_back(TokenType::EXCLAMATION, "!", line, col - 1);
                 }
+                continue;
+            }
 
-                size_t depth = 1;
-                size_t bodyEnd = bodyStart + 1;
-                while (bodyEnd < tokens.size() && depth > 0) {
-                    if (tokens[bodyEnd].type == TokenType::LBRACE) depth++;
-                    else if (tokens[bodyEnd].type == TokenType::RBRACE) depth--;
-                    bodyEnd++;
+            if (c == '"') {
+                advance();
+                size_t start = pos;
+                while (pos < src.size() && src[pos] != '"') {
+                    if (src[pos] == '\n') {
+                        error(filename, line, col, "字符串字面量未闭合");
+                    }
+                    advance();
                 }
-                if (depth != 0) {
-                    error(filename, t.line, t.col, "函数定义缺少闭合的 \'}\'");
+                if (pos >= src.size()) {
+                    error(filename, line, col, "未找到闭合的字符串字面量");
                 }
-
-                std::vector<Token> body(tokens.begin() + bodyStart + 1, 
-                                       tokens.begin() + bodyEnd - 1);
-
-                functions[funcName] = Function(funcName, body, hasReturn);
-
-                ip = bodyEnd;
+                std::string s = src.substr(start, pos - start);
+                advance();
+                tokens.emplace_back(TokenType::STRING, s, line, col - (pos - start) - 1);
                 continue;
             }
 
-            
-            if (t.type == TokenType::IDENTIFIER && ip + 1 < tokens.size() &&
-                tokens[ip+1].type == TokenType::LPAREN) {
-
-                std::string funcName = t.lexeme;
-                size_t startIp = ip;
-
-                ip += 2;
-
-                std::vector<std::string> args;
-
-                int parenDepth = 1;
-                size_t paramStart = ip;
-
-                while (ip < tokens.size() && parenDepth > 0) {
-                    if (tokens[ip].type == TokenType::LPAREN) parenDepth++;
-                    else if (tokens[ip].type == TokenType::RPAREN) parenDepth--;
-                    ip++;
+            if (match("accept")) {
+                tokens.emplace_back(TokenType::ACCEPT, "accept", line, col);
+                pos += 6;
+                col += 6;
+                while (pos < src.size() && isspace(src[pos])) {
+                    advance();
                 }
-
-                if (parenDepth != 0) {
-                    ip = startIp;
-                } else {
-                    size_t paramEnd = ip - 1;
-
-                    if (paramEnd > paramStart) {
-                        size_t paramIdx = paramStart;
-                        while (paramIdx < paramEnd && tokens[paramIdx].type == TokenType::COMMA) {
-                            paramIdx++;
-                        }
-
-                        if (paramIdx < paramEnd) {
-                            if (tokens[paramIdx].type == TokenType::IDENTIFIER) {
-                                if (!hasVar(tokens[paramIdx].lexeme)) {
-                                    error(filename, tokens[paramIdx].line, tokens[paramIdx].col,
-                                          "函数参数变量 \'" + tokens[paramIdx].lexeme + "\' 未声明");
-                                }
-                                args.push_back(getVar(tokens[paramIdx].lexeme));
-                            } else if (tokens[paramIdx].type == TokenType::NUMBER) {
-                                args.push_back(tokens[paramIdx].lexeme);
-                            } else if (tokens[paramIdx].type == TokenType::STRING) {
-                                args.push_back(tokens[paramIdx].lexeme);
-                            }
-                        }
-                    }
+                if (pos < src.size() && src[pos] == '>') {
+                    advance();
                 }
+                continue;
+            }
 
-                if (ip < tokens.size() && tokens[ip].type == TokenType::SEMICOLON) {
-                    callFunction(funcName, args, ip);
-                    ip++;
-                    continue;
-                } else {
-                    ip = startIp;
+            if (match("create")) {
+                pos += 6;
+                col += 6;
+                if (pos < src.size() && src[pos] == '.') {
+                    advance();
+                    if (match("int")) {
+                        tokens.emplace_back(TokenType::CREATE_INT, "create.int", line, col - 7);
+                        pos += 3;
+                        col += 3;
+                        in_create = true;
+                        continue;
+                    }
+                    if (match("double")) {
+                        tokens.emplace_back(TokenType::CREATE_DOUBLE, "create.double", line, col - 7);
+                        pos += 6;
+                        col += 6;
+                        in_create = true;
+                        continue;
+                    }
+                    if (match("omni")) {
+                        tokens.emplace_back(TokenType::CREATE_OMNI, "create.omni", line, col - 7);
+                        pos += 4;
+                        col += 4;
+                        in_create = true;
+                        continue;
+                    }
+                    if (match("string")) {
+                        tokens.emplace_back(TokenType::CREATE_STRING, "create.string", line, col - 7);
+                        pos += 6;
+                        col += 6;
+                        in_create = true;
+                        continue;
+                    }
+                    if (match("arr")) {
+                        tokens.emplace_back(TokenType::CREATE_ARR, "create.arr", line, col - 7);
+                        pos += 3;
+                        col += 3;
+                        in_create = true;
+                        continue;
+                    }
+                    if (match("record")) {
+                        tokens.emplace_back(TokenType::CREATE_RECORD, "create.record", line, col - 7);
+                        pos += 6;
+                        col += 6;
+                        in_create = true;
+                        continue;
+                    }
+                    if (match("heap")) {
+                        tokens.emplace_back(TokenType::CREATE_HEAP, "create.heap", line, col - 7);
+                        pos += 4;
+                        col += 4;
+                        in_create = true;
+                        continue;
+                    }
+                    if (match("dict")) {
+                        tokens.emplace_back(TokenType::CREATE_DICT, "create.dict", line, col - 7);
+                        pos += 4;
+                        col += 4;
+                        in_create = true;
+                        continue;
+                    }
+                    if (match("sort")) {
+                        tokens.emplace_back(TokenType::CREATE_SORT, "create.sort", line, col - 7);
+                        pos += 4;
+                        col += 4;
+                        in_create = true;
+                        continue;
+                    }
+                    if (match("sum")) {
+                        tokens.emplace_back(TokenType::CREATE_SUM, "create.sum", line, col - 7);
+                        pos += 3;
+                        col += 3;
+                        in_create = true;
+                        continue;
+                    }
+                    if (match("sqrt")) {
+                        tokens.emplace_back(TokenType::CREATE_SQRT, "create.sqrt", line, col - 7);
+                        pos += 4;
+                        col += 4;
+                        in_create = true;
+                        continue;
+                    }
                 }
+                tokens.emplace_back(TokenType::CREATE, "create", line, col - 6);
+                continue;
             }
 
-            
-            if (t.type == TokenType::OUTPUT_REDIRECT) {
-                std::vector<Token> outputTokens;
-                outputTokens.push_back(tokens[ip]);
-                ip++;
-                while (ip < tokens.size() && tokens[ip].type != TokenType::SEMICOLON) {
-                    outputTokens.push_back(tokens[ip]);
-                    ip++;
+            if (match("output")) {
+                tokens.emplace_back(TokenType::OUTPUT_REDIRECT, "output", line, col);
+                pos += 6;
+                col += 6;
+                while (pos < src.size() && isspace(src[pos])) {
+                    advance();
                 }
-                if (ip >= tokens.size() || tokens[ip].type != TokenType::SEMICOLON) {
-                    error(filename, t.line, t.col, "输出语句缺少分号");
+                if (pos < src.size() && src[pos] == '>') {
+                    advance();
+                    in_output_redirect = true;
                 }
-                ip++;
-                parseOutputStatement(outputTokens);
                 continue;
             }
 
-            
-            if (t.type == TokenType::OUTLB && ip + 1 < tokens.size() &&
-                tokens[ip+1].type == TokenType::SEMICOLON) {
-                std::cout << std::endl;
-                ip += 2;
+            if (match("input")) {
+                pos += 5;
+                col += 5;
+                while (pos < src.size() && isspace(src[pos])) {
+                    advance();
+                }
+                if (pos < src.size() && src[pos] == '>') {
+                    tokens.emplace_back(TokenType::INPUT_REDIRECT, "input>", line, col - 5);
+                    advance();
+                } else {
+                    tokens.emplace_back(TokenType::IDENTIFIER, "input", line, col - 5);
+                }
                 continue;
             }
 
-            
-            if (t.type == TokenType::INPUT_REDIRECT && ip + 2 < tokens.size() &&
-                tokens[ip+1].type == TokenType::IDENTIFIER &&
-                tokens[ip+2].type == TokenType::SEMICOLON) {
-                std::string varName = tokens[ip+1].lexeme;
-                if (!hasVar(varName)) {
-                    error(filename, tokens[ip+1].line, tokens[ip+1].col,
-                          "变量 \'" + varName + "\' 未声明，不能接收输入");
-                }
-                std::string input;
-                std::getline(std::cin, input);
-                VarType type = getVarType(varName);
-                setVar(varName, type, input);
-                ip += 3;
+            if (match("function")) {
+                tokens.emplace_back(TokenType::FUNCTION, "function", line, col);
+                pos += 8;
+                col += 8;
                 continue;
             }
 
-            
-            if (parseAssignment(tokens, ip)) {
+            if (in_output_redirect && c == '>') {
+                tokens.emplace_back(TokenType::OUTPUT_CONNECT, ">", line, col);
+                advance();
                 continue;
             }
 
-            
-            if (t.type == TokenType::IF && ip + 5 < tokens.size() &&
-                tokens[ip+1].type == TokenType::LPAREN &&
-                tokens[ip+2].type == TokenType::IDENTIFIER &&
-                (tokens[ip+3].type == TokenType::GT || tokens[ip+3].type == TokenType::LT ||
-                 tokens[ip+3].type == TokenType::GTE || tokens[ip+3].type == TokenType::LTE ||
-                 tokens[ip+3].type == TokenType::EQ || tokens[ip+3].type == TokenType::NEQ) &&
-                (tokens[ip+4].type == TokenType::NUMBER || tokens[ip+4].type == TokenType::IDENTIFIER) &&
-                tokens[ip+5].type == TokenType::RPAREN) {
+            if (match("outlb")) {
+                tokens.emplace_back(TokenType::OUTLB, "outlb", line, col);
+                pos += 5;
+                col += 5;
+                continue;
+            }
 
-                std::string varName = tokens[ip+2].lexeme;
-                std::string op = tokens[ip+3].lexeme;
-                std::string limitStr = tokens[ip+4].lexeme;
-                int limit = 0;
-                if (tokens[ip+4].type == TokenType::NUMBER) {
-                    limit = stringToDouble(limitStr);
-                } else {
-                    if (!hasVar(limitStr)) {
-                        error(filename, tokens[ip+4].line, tokens[ip+4].col,
-                              "变量 \'" + limitStr + "\' 未声明");
-                    }
-                    limit = getNumericVar(limitStr);
-                }
-                if (!hasVar(varName)) {
-                    error(filename, tokens[ip+2].line, tokens[ip+2].col,
-                          "变量 \'" + varName + "\' 未声明");
-                }
-                double cur = getNumericVar(varName);
-                bool cond = false;
-                if (op == ">") cond = (cur > limit);
-                else if (op == "<") cond = (cur < limit);
-                else if (op == ">=") cond = (cur >= limit);
-                else if (op == "<=") cond = (cur <= limit);
-                else if (op == "==") cond = (cur == limit);
-                else if (op == "!=") cond = (cur != limit);
+            if (match("for")) {
+                tokens.emplace_back(TokenType::FOR, "for", line, col);
+                pos += 3;
+                col += 3;
+                continue;
+            }
 
-                size_t braceStart = ip + 6;
-                if (braceStart >= tokens.size() || tokens[braceStart].type != TokenType::LBRACE) {
-                    error(filename, t.line, t.col, "if 语句缺少 {");
-                }
-                size_t braceEnd = braceStart + 1;
-                int depth = 1;
-                while (braceEnd < tokens.size() && depth > 0) {
-                    if (tokens[braceEnd].type == TokenType::LBRACE) depth++;
-                    else if (tokens[braceEnd].type == TokenType::RBRACE) depth--;
-                    braceEnd++;
-                }
-                if (depth != 0) error(filename, t.line, t.col, "if 语句缺少闭合的 }");
+            if (match("while")) {
+                tokens.emplace_back(TokenType::WHILE, "while", line, col);
+                pos += 5;
+                col += 5;
+                continue;
+            }
 
-                if (cond) {
-                    std::vector<Token> body(tokens.begin() + braceStart + 1, tokens.begin() + braceEnd - 1);
-                    Interpreter sub(filename);
-                    sub.vars = vars;
-                    sub.execute(body);
-                    vars = sub.vars;
-                }
-                ip = braceEnd;
+            if (match("if")) {
+                tokens.emplace_back(TokenType::IF, "if", line, col);
+                pos += 2;
+                col += 2;
                 continue;
             }
 
-            
-            if (t.type == TokenType::WHILE && ip + 5 < tokens.size() &&
-                tokens[ip+1].type == TokenType::LPAREN &&
-                tokens[ip+2].type == TokenType::IDENTIFIER &&
-                (tokens[ip+3].type == TokenType::LT || tokens[ip+3].type == TokenType::LTE ||
-                 tokens[ip+3].type == TokenType::GT || tokens[ip+3].type == TokenType::GTE ||
-                 tokens[ip+3].type == TokenType::EQ || tokens[ip+3].type == TokenType::NEQ) &&
-                (tokens[ip+4].type == TokenType::NUMBER || tokens[ip+4].type == TokenType::IDENTIFIER) &&
-                tokens[ip+5].type == TokenType::RPAREN) {
+            if (match("loop")) {
+                tokens.emplace_back(TokenType::LOOP, "loop", line, col);
+                pos += 4;
+                col += 4;
+                continue;
+            }
 
-                std::string varName = tokens[ip+2].lexeme;
-                std::string op = tokens[ip+3].lexeme;
-                std::string limitStr = tokens[ip+4].lexeme;
-                int limit = 0;
-                if (tokens[ip+4].type == TokenType::NUMBER) {
-                    limit = stringToDouble(limitStr);
-                } else {
-                    if (!hasVar(limitStr)) {
-                        error(filename, tokens[ip+4].line, tokens[ip+4].col,
-                              "变量 \'" + limitStr + "\' 未声明");
-                    }
-                    limit = getNumericVar(limitStr);
+            if (match("finish")) {
+                tokens.emplace_back(TokenType::FINISH, "finish", line, col);
+                pos += 6;
+                col += 6;
+                continue;
+            }
+
+            if (isdigit(c)) {
+                size_t start = pos;
+                while (pos < src.size() && isdigit(src[pos])) {
+                    advance();
                 }
-                if (!hasVar(varName)) {
-                    error(filename, tokens[ip+2].line, tokens[ip+2].col,
-                          "变量 \'" + varName + "\' 未声明");
+                if (pos < src.size() && src[pos] == '.') {
+                    advance();
+                    while (pos < src.size() && isdigit(src[pos])) {
+                        advance();
+                    }
                 }
+                std::string num = src.substr(start, pos - start);
+                tokens.emplace_back(TokenType::NUMBER, num, line, col - (pos - start));
+                continue;
+            }
 
-                size_t braceStart = ip + 6;
-                if (braceStart >= tokens.size() || tokens[braceStart].type != TokenType::LBRACE) {
-                    error(filename, t.line, t.col, "while 循环缺少 {");
+            if (isalpha(c)) {
+                size_t start = pos;
+                while (pos < src.size() && (isalnum(src[pos]) || src[pos] == '_')) {
+                    advance();
                 }
-                size_t braceEnd = braceStart + 1;
-                int depth = 1;
-                while (braceEnd < tokens.size() && depth > 0) {
-                    if (tokens[braceEnd].type == TokenType::LBRACE) depth++;
-                    else if (tokens[braceEnd].type == TokenType::RBRACE) depth--;
-                    braceEnd++;
+                std::string word = src.substr(start, pos - start);
+                if (word == "if") {
+                    tokens.emplace_back(TokenType::IF, word, line, col - (pos - start));
+                    continue;
                 }
-                if (depth != 0) error(filename, t.line, t.col, "while 循环缺少闭合的 }");
-
-                while (true) {
-                    double cur = getNumericVar(varName);
-                    bool cond = false;
-                    if (op == "<") cond = (cur < limit);
-                    else if (op == "<=") cond = (cur <= limit);
-                    else if (op == ">") cond = (cur > limit);
-                    else if (op == ">=") cond = (cur >= limit);
-                    else if (op == "==") cond = (cur == limit);
-                    else if (op == "!=") cond = (cur != limit);
-                    if (!cond) break;
+                if (word == "while") {
+                    tokens.emplace_back(TokenType::WHILE, word, line, col - (pos - start));
+                    continue;
+                }
+                if (word == "for") {
+                    tokens.emplace_back(TokenType::FOR, word, line, col - (pos - start));
+                    continue;
+                }
+                if (word == "loop") {
+                    tokens.emplace_back(TokenType::LOOP, word, line, col - (pos - start));
+                    continue;
+                }
+                if (word == "outlb") {
+                    tokens.emplace_back(TokenType::OUTLB, word, line, col - (pos - start));
+                    continue;
+                }
+                if (word == "finish") {
+                    tokens.emplace_back(TokenType::FINISH, word, line, col - (pos - start));
+                    continue;
+                }
+                if (word == "function") {
+                    tokens.emplace_back(TokenType::FUNCTION, word, line, col - (pos - start));
+                    continue;
+                }
+                if (word == "accept") {
+                    tokens.emplace_back(TokenType::ACCEPT, word, line, col - (pos - start));
+                    continue;
+                }
+                if (word == "dtime_tic") {
+                    tokens.emplace_back(TokenType::DTIME_TIC, word, line, col - (pos - start));
+                    continue;
+                }
+                if (word == "dtime_toc") {
+                    tokens.emplace_back(TokenType::DTIME_TOC, word, line, col - (pos - start));
+                    continue;
+                }
+                if (word == "random") {
+                    tokens.emplace_back(TokenType::RANDOM, word, line, col - (pos - start));
+                    continue;
+                }
+                tokens.emplace_back(TokenType::IDENTIFIER, word, line, col - (pos - start));
+                continue;
+            }
 
-                    std::vector<Token> body(tokens.begin() + braceStart + 1, tokens.begin() + braceEnd - 1);
-                    Interpreter sub(filename);
-                    sub.vars = vars;
-                    sub.execute(body);
-                    vars = sub.vars;
+            if (c == '.') {
+                advance();
+                if (match("falid")) {
+                    tokens.emplace_back(TokenType::FALID, ".falid", line, col - 1);
+                    pos += 5;
+                    col += 5;
+                } else if (match("valid")) {
+                    tokens.emplace_back(TokenType::VALID, ".valid", line, col - 1);
+                    pos += 5;
+                    col += 5;
+                } else if (match("void")) {
+                    tokens.emplace_back(TokenType::VOID_TYPE, ".void", line, col - 1);
+                    pos += 4;
+                    col += 4;
+                } else {
+                    tokens.emplace_back(TokenType::DOT, ".", line, col - 1);
                 }
-                ip = braceEnd;
                 continue;
             }
 
-            
-            if (t.type == TokenType::LOOP && ip + 3 < tokens.size() &&
-                tokens[ip+1].type == TokenType::LPAREN) {
+            if (c == '|') {
+                tokens.emplace_back(TokenType::PIPE, "|", line, col);
+                advance();
+                continue;
+            }
 
-                int count = 0;
-                if (tokens[ip+2].type == TokenType::NUMBER) {
-                    count = stringToDouble(tokens[ip+2].lexeme);
-                } else if (tokens[ip+2].type == TokenType::IDENTIFIER) {
-                    if (!hasVar(tokens[ip+2].lexeme)) {
-                        error(filename, tokens[ip+2].line, tokens[ip+2].col,
-                              "变量 \'" + tokens[ip+2].lexeme + "\' 未声明");
-                    }
-                    count = getNumericVar(tokens[ip+2].lexeme);
+            if (c == '=') {
+                advance();
+                if (pos < src.size() && src[pos] == '=') {
+                    tokens.emplace_back(TokenType::EQ, "==", line, col - 1);
+                    advance();
                 } else {
-                    error(filename, t.line, t.col, "loop 循环次数必须是数字或标识符");
+                    tokens.emplace_back(TokenType::ASSIGN, "=", line, col);
                 }
-                if (tokens[ip+3].type != TokenType::RPAREN) {
-                    error(filename, t.line, t.col, "loop 语句括号不匹配");
+                continue;
+            }
+
+            if (c == '!') {
+                advance();
+                if (pos < src.size() && src[pos] == '=') {
+                    tokens.emplace_back(TokenType::NEQ, "!=", line, col - 1);
+                    advance();
+                } else {
+                    error(filename, line, col, "不支持的字符 \'" + std::string(1, c) + "\'");
                 }
+                continue;
+            }
 
-                size_t braceStart = ip + 4;
-                if (braceStart >= tokens.size() || tokens[braceStart].type != TokenType::LBRACE) {
-                    error(filename, t.line, t.col, "loop 语句缺少 {");
+            if (c == '>') {
+                advance();
+                if (pos < src.size() && src[pos] == '=') {
+                    tokens.emplace_back(TokenType::GTE, ">=", line, col - 1);
+                    advance();
+                } else {
+                    tokens.emplace_back(TokenType::GT, ">", line, col - 1);
                 }
-                size_t braceEnd = braceStart + 1;
-                int depth = 1;
-                while (braceEnd < tokens.size() && depth > 0) {
-                    if (tokens[braceEnd].type == TokenType::LBRACE) depth++;
-                    else if (tokens[braceEnd].type == TokenType::RBRACE) depth--;
-                    braceEnd++;
+                continue;
+            }
+
+            if (c == '<') {
+                advance();
+                if (pos < src.size() && src[pos] == '=') {
+                    tokens.emplace_back(TokenType::LTE, "<=", line, col - 1);
+                    advance();
+                } else {
+                    tokens.emplace_back(TokenType::LT, "<", line, col - 1);
                 }
-                if (depth != 0) error(filename, t.line, t.col, "loop 语句缺少闭合的 }");
+                continue;
+            }
 
-                std::vector<Token> body(tokens.begin() + braceStart + 1, tokens.begin() + braceEnd - 1);
-                for (int i = 0; i < count; i++) {
-                    Interpreter sub(filename);
-                    sub.vars = vars;
-                    sub.execute(body);
-                    vars = sub.vars;
+            if (c == '+') {
+                advance();
+                if (pos < src.size() && src[pos] == '=') {
+                    tokens.emplace_back(TokenType::PLUS_EQUALS, "+=", line, col - 1);
+                    advance();
+                } else if (pos < src.size() && src[pos] == '+') {
+                    tokens.emplace_back(TokenType::PLUS_PLUS, "++", line, col - 1);
+                    advance();
+                } else {
+                    tokens.emplace_back(TokenType::PLUS, "+", line, col);
                 }
-                ip = braceEnd;
                 continue;
             }
 
-            
-            if (t.type == TokenType::FOR && ip + 13 < tokens.size() &&
-                tokens[ip+1].type == TokenType::LPAREN &&
-                tokens[ip+2].type == TokenType::CREATE_INT &&
-                tokens[ip+3].type == TokenType::IDENTIFIER &&
-                tokens[ip+4].type == TokenType::ASSIGN &&
-                (tokens[ip+5].type == TokenType::NUMBER || tokens[ip+5].type == TokenType::IDENTIFIER) &&
-                tokens[ip+6].type == TokenType::SEMICOLON &&
-                tokens[ip+7].type == TokenType::IDENTIFIER &&
-                (tokens[ip+8].type == TokenType::LT || tokens[ip+8].type == TokenType::LTE ||
-                 tokens[ip+8].type == TokenType::GT || tokens[ip+8].type == TokenType::GTE ||
-                 tokens[ip+8].type == TokenType::EQ) &&
-                (tokens[ip+9].type == TokenType::NUMBER || tokens[ip+9].type == TokenType::IDENTIFIER) &&
-                tokens[ip+10].type == TokenType::SEMICOLON &&
-                tokens[ip+11].type == TokenType::IDENTIFIER &&
-                tokens[ip+12].type == TokenType::PLUS_PLUS &&
-                tokens[ip+13].type == TokenType::RPAREN) {
+            if (c == '-') {
+                advance();
+                if (pos < src.size() && src[pos] == '=') {
+                    tokens.emplace_back(TokenType::MINUS_EQUALS, "-=", line, col - 1);
+                    advance();
+                } else if (pos < src.size() && src[pos] == '-') {
+                    tokens.emplace_back(TokenType::MINUS_MINUS, "--", line, col - 1);
+                    advance();
+                } else {
+                    tokens.emplace_back(TokenType::MINUS, "-", line, col);
+                }
+                continue;
+            }
 
-                std::string initVar = tokens[ip+3].lexeme;
-                std::string initValStr = tokens[ip+5].lexeme;
-                int initVal = 0;
-                if (tokens[ip+5].type == TokenType::NUMBER) {
-                    initVal = stringToDouble(initValStr);
+            if (c == '*') {
+                advance();
+                if (pos < src.size() && src[pos] == '=') {
+                    tokens.emplace_back(TokenType::STAR_EQUALS, "*=", line, col - 1);
+                    advance();
                 } else {
-                    if (!hasVar(initValStr)) {
-                        error(filename, tokens[ip+5].line, tokens[ip+5].col,
-                              "变量 \'" + initValStr + "\' 未声明");
-                    }
-                    initVal = getNumericVar(initValStr);
+                    tokens.emplace_back(TokenType::MULTIPLY, "*", line, col);
                 }
-                std::string condVar = tokens[ip+7].lexeme;
-                std::string op = tokens[ip+8].lexeme;
-                std::string limitStr = tokens[ip+9].lexeme;
-                int limit = 0;
-                if (tokens[ip+9].type == TokenType::NUMBER) {
-                    limit = stringToDouble(limitStr);
+                continue;
+            }
+
+            if (c == '/') {
+                advance();
+                if (pos < src.size() && src[pos] == '=') {
+                    tokens.emplace_back(TokenType::SLASH_EQUALS, "/=", line, col - 1);
+                    advance();
                 } else {
-                    if (!hasVar(limitStr)) {
-                        error(filename, tokens[ip+9].line, tokens[ip+9].col,
-                              "变量 \'" + limitStr + "\' 未声明");
-                    }
-                    limit = getNumericVar(limitStr);
+                    tokens.emplace_back(TokenType::DIVIDE, "/", line, col);
                 }
-                std::string updateVar = tokens[ip+11].lexeme;
+                continue;
+            }
+
+            if (c == '[') {
+                tokens.emplace_back(TokenType::LBRACKET, "[", line, col);
+                advance();
+                continue;
+            }
+            if (c == ']') {
+                tokens.emplace_back(TokenType::RBRACKET, "]", line, col);
+                advance();
+                continue;
+            }
+
+            
+            if (c == '~') {
+                tokens.emplace_back(TokenType::TILDE, "~", line, col);
+                advance();
+                continue;
+            }
+
+            switch (c) {
+            case '(': tokens.emplace_back(TokenType::LPAREN, "(", line, col); break;
+            case ')': tokens.emplace_back(TokenType::RPAREN, ")", line, col); break;
+            case '{': tokens.emplace_back(TokenType::LBRACE, "{", line, col); break;
+            case '}': tokens.emplace_back(TokenType::RBRACE, "}", line, col); break;
+            case ';':
+                tokens.emplace_back(TokenType::SEMICOLON, ";", line, col);
+                advance();
+                if (in_output_redirect) in_output_redirect = false;
+                if (in_create) in_create = false;
+                continue;
+            case ',':
+                tokens.emplace_back(TokenType::COMMA, ",", line, col);
+                advance();
+                continue;
+            case '#':
+                while (pos < src.size() && src[pos] != '\n') advance();
+                continue;
+            case '?':
+                tokens.emplace_back(TokenType::QUESTION, "?", line, col);
+                advance();
+                continue;
+            case ':':
+                tokens.emplace_back(TokenType::COLON, ":", line, col);
+                advance();
+                continue;
+            default:
+                if (!isspace(c)) {
+                    error(filename, line, col, "不支持的字符 \'" + std::string(1, c) + "\'");
+                }
+            }
+            advance();
+        }
+
+        tokens.emplace_back(TokenType::EOF_TOKEN, "", line, col);
+        return tokens;
+    }
+};
+
+
+struct Interpreter {
+    std::map<std::string, Variable> vars;
+    std::map<std::string, Function> functions;
+    std::map<std::string, std::shared_ptr<const RecordLayout>> recordTypes;
+    std::string filename;
+    std::stack<std::map<std::string, Variable>> callStack;
+    TimerState timer;
+    double lastTocTime;
+    bool hasTocExecuted;
+    std::mt19937 rng;  
+
+    Interpreter(const std::string& fname) 
+        : filename(fname), lastTocTime(0.0), hasTocExecuted(false),
+          rng(std::random_device{}()) {}
+
+    
+    void setVar(const std::string& name, VarType type, const std::string& value) {
+        vars[name] = Variable(type, value);
+    }
+
+    
+    void setArrayVar(const std::string& name, const std::vector<Variable>& elements) {
+        Variable arr(VarType::ARRAY);
+        arr.setDims({elements.size()});
+        for (size_t i = 0; i < elements.size(); ++i) {
+            arr.setPhysical(i, elements[i]);
+        }
+        vars[name] = arr;
+    }
+
+    
+    void setArrayElement(const std::string& name, size_t index, const Variable& value) {
+        auto it = vars.find(name);
+        if (it == vars.end()) {
+            error(filename, 0, 0, "未声明的数组 \'" + name + "\'");
+        }
+        if (!it->second.isArray()) {
+            error(filename, 0, 0, "变量 \'" + name + "\' 不是数组类型");
+        }
+        if (index >= it->second.getArraySize()) {
+            error(filename, 0, 0, "数组索引越界: " + name + "[" + std::to_string(index) + "]");
+        }
+        it->second.setPhysical(it->second.elementIndex<1>({index}), value);
+    }
+
+    
+    std::string getVar(const std::string& name) {
+        auto it = vars.find(name);
+        if (it == vars.end()) {
+            error(filename, 0, 0, "未声明的变量 \'" + name + "\'");
+        }
+        return it->second.displayString();
+    }
+
+    
+    std::string getArrayElement(const std::string& name, size_t index) {
+        auto it = vars.find(name);
+        if (it == vars.end()) {
+            error(filename, 0, 0, "未声明的数组 \'" + name + "\'");
+        }
+        if (!it->second.isArray()) {
+            error(filename, 0, 0, "变量 \'" + name + "\' 不是数组类型");
+        }
+        if (index >= it->second.getArraySize()) {
+            error(filename, 0, 0, "数组索引越界: " + name + "[" + std::to_string(index) + "]");
+        }
+        return it->second.store->textAt(it->second.elementIndex<1>({index}));
+    }
+
+    
+    double getNumericVar(const std::string& name) {
+        auto it = vars.find(name);
+        if (it == vars.end()) {
+            error(filename, 0, 0, "未声明的变量 \'" + name + "\'");
+        }
+        if (!it->second.isNumeric()) {
+            error(filename, 0, 0, "变量 \'" + name + "\' 不是数值类型");
+        }
+        return it->second.getNumericValue();
+    }
+
+    
+    double getNumericArrayElement(const std::string& name, size_t index) {
+        auto it = vars.find(name);
+        if (it == vars.end()) {
+            error(filename, 0, 0, "未声明的数组 \'" + name + "\'");
+        }
+        if (!it->second.isArray()) {
+            error(filename, 0, 0, "变量 \'" + name + "\' 不是数组类型");
+        }
+        if (index >= it->second.getArraySize()) {
+            error(filename, 0, 0, "数组索引越界: " + name + "[" + std::to_string(index) + "]");
+        }
+        return it->second.store->numberAt(it->second.elementIndex<1>({index}));
+    }
+
+    
+    VarType getVarType(const std::string& name) {
+        auto it = vars.find(name);
+        if (it == vars.end()) {
+            error(filename, 0, 0, "未声明的变量 \'" + name + "\'");
+        }
+        return it->second.type;
+    }
+
+    
+    size_t getArraySize(const std::string& name) {
+        auto it = vars.find(name);
+        if (it == vars.end()) {
+            error(filename, 0, 0, "未声明的数组 \'" + name + "\'");
+        }
+        if (!it->second.isArray()) {
+            error(filename, 0, 0, "变量 \'" + name + "\' 不是数组类型");
+        }
+        return it->second.getArraySize();
+    }
+
+    
+    bool hasVar(const std::string& name) {
+        return vars.find(name) != vars.end();
+    }
+
+    
+    bool isArrayVar(const std::string& name) {
+        auto it = vars.find(name);
+        if (it == vars.end()) return false;
+        return it->second.isArray();
+    }
+
+    
+    std::string getTypeName(VarType type) {
+        switch (type) {
+        case VarType::INT: return "int";
+        case VarType::DOUBLE: return "double";
+        case VarType::OMNI: return "omni";
+        case VarType::STRING: return "string";
+        case VarType::ARRAY: return "array";
+        default: return "unknown";
+        }
+    }
+
+    
+    double stringToDouble(const std::string& str) {
+        double v = 0;
+        if (!scanNumber(str, v)) {
+            error(filename, 0, 0, "无法将字符串 \'" + str + "\' 转换为数字");
+        }
+        return v;
+    }
+
+    
+    std::string doubleToString(double num) {
+        return formatNumber(num);
+    }
+
+private:
+    
+    double parseFactor(const std::vector<Token>& tokens, size_t& index) {
+        if (index >= tokens.size()) {
+            error(filename, 0, 0, "表达式意外结束");
+        }
+
+        if (tokens[index].type == TokenType::MINUS) {
+            index++;
+            return -parseFactor(tokens, index);
+        }
+
+        if (tokens[index].type == TokenType::LPAREN) {
+            index++;
+            double result = parseExpression(tokens, index);
+            if (index >= tokens.size() || tokens[index].type != TokenType::RPAREN) {
+                error(filename, tokens[index].line, tokens[index].col, "缺少闭合括号 \')\'");
+            }
+            index++;
+            return result;
+        }
+
+        if (tokens[index].type == TokenType::NUMBER) {
+            double value = stringToDouble(tokens[index].lexeme);
+            index++;
+            return value;
+        }
+
+        if (isBuiltinCall(tokens, index)) {
+            const Token& callee = tokens[index];
+            Variable result = callBuiltin(tokens, index);
+            if (result.isContainer() || result.type == VarType::STRING) {
+                error(filename, callee.line, callee.col,
+                      "函数 \'" + callee.lexeme + "\' 的结果不是数值，不能用于表达式");
+            }
+            return result.getNumericValue();
+        }
+
+        if (isRecordRef(tokens, index)) {
+            FieldRef ref = parseFieldRef(tokens, index);
+            return ref.column->numberAt(ref.row);
+        }
+
+        if (tokens[index].type == TokenType::IDENTIFIER) {
+            const std::string& varName = tokens[index].lexeme;
+            index++;
+
+            if (index < tokens.size() && tokens[index].type == TokenType::LBRACKET) {
+                const Token& at = tokens[index-1];
+                auto dictIt = vars.find(varName);
+                if (dictIt != vars.end() && dictIt->second.isDict()) {
+                    const DictKey& v = dictEntry(dictIt->second, tokens, index, at);
+                    return v.numeric ? v.num : textToNumber(v.text);
+                }
+                const Variable& arr = arrayVar(varName, at);
+                if (!isElementSubscripts(tokens, index, arr)) {
+                    error(filename, at.line, at.col, "数组切片 \'" + varName + "\' 不能直接用于数值表达式");
+                }
+                return arr.store->numberAt(parseElementOffset(tokens, index, arr, at));
+            }
+
+            return getNumericVar(varName);
+        }
+
+        if (tokens[index].type == TokenType::DTIME_FUNC) {
+            index++;
+            if (!hasTocExecuted) {
+                error(filename, tokens[index-1].line, tokens[index-1].col, 
+                      "dtime() 必须在 dtime_toc 之后使用");
+            }
+            return lastTocTime;
+        }
+
+        error(filename, tokens[index].line, tokens[index].col,
+              "表达式中期望数字、变量或括号，但得到 \'" + tokens[index].lexeme + "\'");
+        return 0.0;
+    }
+
+    
+    double parseTerm(const std::vector<Token>& tokens, size_t& index) {
+        double result = parseFactor(tokens, index);
+        while (index < tokens.size() &&
+               (tokens[index].type == TokenType::MULTIPLY ||
+                tokens[index].type == TokenType::DIVIDE)) {
+            std::string op = tokens[index].lexeme;
+            index++;
+            double right = parseFactor(tokens, index);
+            result = performArithmeticOp(result, op, right);
+        }
+        return result;
+    }
+
+    
+    double parseExpression(const std::vector<Token>& tokens, size_t& index) {
+        double result = parseTerm(tokens, index);
+        while (index < tokens.size() &&
+               (tokens[index].type == TokenType::PLUS ||
+                tokens[index].type == TokenType::MINUS)) {
+            std::string op = tokens[index].lexeme;
+            index++;
+            double right = parseTerm(tokens, index);
+            result = performArithmeticOp(result, op, right);
+        }
+        return result;
+    }
+
+    
+    double performArithmeticOp(double left, const std::string& op, double right) {
+        if (op == "+") return left + right;
+        if (op == "-") return left - right;
+        if (op == "*") return left * right;
+        if (op == "/") {
+            if (right == 0) error(filename, 0, 0, "除零错误");
+            return left / right;
+        }
+        error(filename, 0, 0, "未知运算符 \'" + op + "\'");
+        return 0;
+    }
+
+public:
+    
+    double evaluateExpr(const std::vector<Token>& tokens, size_t& index) {
+        return parseExpression(tokens, index);
+    }
+
+    
+    struct CallArgs {
+        const std::vector<Token>& tokens;
+        const Token& callee;
+        std::vector<std::pair<size_t, size_t>> ranges;
+
+        CallArgs(const std::vector<Token>& t, const Token& c) : tokens(t), callee(c) {}
+        size_t size() const { return ranges.size(); }
+    };
+
+    using Builtin = Variable (Interpreter::*)(CallArgs&);
+
+    
+    static const std::map<std::string, Builtin>& builtinTable() {
+        static const std::map<std::string, Builtin> table = {
+            {"sum", &Interpreter::builtinSum},
+            {"mean", &Interpreter::builtinMean},
+            {"min", &Interpreter::builtinMin},
+            {"max", &Interpreter::builtinMax},
+            {"argmin", &Interpreter::builtinArgmin},
+            {"argmax", &Interpreter::builtinArgmax},
+            {"prod", &Interpreter::builtinProd},
+            {"dot", &Interpreter::builtinDot},
+            {"scan", &Interpreter::builtinScan},
+            {"sort", &Interpreter::builtinSort},
+            {"sorted", &Interpreter::builtinSorted},
+            {"matmul", &Interpreter::builtinMatmul},
+            {"transpose", &Interpreter::builtinTranspose},
+            {"matvec", &Interpreter::builtinMatvec},
+            {"outer", &Interpreter::builtinOuter},
+            {"len", &Interpreter::builtinLen},
+            {"push", &Interpreter::builtinPush},
+            {"pop", &Interpreter::builtinPop},
+            {"insert", &Interpreter::builtinInsert},
+            {"reserve", &Interpreter::builtinReserve},
+            {"resize", &Interpreter::builtinResize},
+            {"sparse", &Interpreter::builtinSparse},
+            {"nnz", &Interpreter::builtinNnz},
+            {"has", &Interpreter::builtinHas},
+            {"get", &Interpreter::builtinGet},
+            {"set", &Interpreter::builtinSet},
+            {"erase", &Interpreter::builtinErase},
+            {"keys", &Interpreter::builtinKeys},
+            {"values", &Interpreter::builtinValues},
+            {"clear", &Interpreter::builtinClear},
+            {"column", &Interpreter::builtinColumn},
+            {"peek", &Interpreter::builtinPeek},
+            {"payload", &Interpreter::builtinPayload},
+            {"heapify", &Interpreter::builtinHeapify},
+            {"topk", &Interpreter::builtinTopk},
+            {"lower_bound", &Interpreter::builtinLowerBound},
+            {"upper_bound", &Interpreter::builtinUpperBound},
+            {"binary_search", &Interpreter::builtinBinarySearch},
+            {"equal_range", &Interpreter::builtinEqualRange},
+            {"sortedindex", &Interpreter::builtinSortedIndex},
+            {"between", &Interpreter::builtinBetween},
+            {"groupby", &Interpreter::builtinGroupby},
+            {"histogram", &Interpreter::builtinHistogram},
+            {"rolling_sum", &Interpreter::builtinRollingSum},
+            {"rolling_mean", &Interpreter::builtinRollingMean},
+            {"rolling_min", &Interpreter::builtinRollingMin},
+            {"rolling_max", &Interpreter::builtinRollingMax},
+            {"ewma", &Interpreter::builtinEwma},
+            {"diff", &Interpreter::builtinDiff},
+            {"cumsum", &Interpreter::builtinCumsum},
+            {"median", &Interpreter::builtinMedian},
+            {"quantile", &Interpreter::builtinQuantile},
+            {"quantiles", &Interpreter::builtinQuantiles},
+            {"tdigest", &Interpreter::builtinTdigest},
+            {"readcsv", &Interpreter::builtinReadcsv},
+            {"csvopen", &Interpreter::builtinCsvopen},
+            {"csvnext", &Interpreter::builtinCsvnext},
+            {"save", &Interpreter::builtinSave},
+            {"load", &Interpreter::builtinLoad},
+            {"mapfile", &Interpreter::builtinMapfile},
+            {"advise", &Interpreter::builtinAdvise},
+            {"sync", &Interpreter::builtinSync},
+            {"tojson", &Interpreter::builtinTojson},
+            {"writejson", &Interpreter::builtinWritejson},
+            {"fromjson", &Interpreter::builtinFromjson},
+            {"loadjson", &Interpreter::builtinLoadjson},
+            {"flush", &Interpreter::builtinFlush},
+        };
+        return table;
+    }
+
+    
+    bool isBuiltinCall(const std::vector<Token>& tokens, size_t index) {
+        return index + 1 < tokens.size() &&
+               tokens[index].type == TokenType::IDENTIFIER &&
+               tokens[index+1].type == TokenType::LPAREN &&
+               builtinTable().count(tokens[index].lexeme) > 0;
+    }
+
+    
+    size_t matchingParen(const std::vector<Token>& tokens, size_t lparen) {
+        int depth = 0;
+        for (size_t i = lparen; i < tokens.size(); ++i) {
+            if (tokens[i].type == TokenType::LPAREN) depth++;
+            else if (tokens[i].type == TokenType::RPAREN && --depth == 0) return i;
+        }
+        error(filename, tokens[lparen].line, tokens[lparen].col, "函数调用缺少 \')\'");
+        return tokens.size();
+    }
+
+    
+    Variable callBuiltin(const std::vector<Token>& tokens, size_t& index) {
+        CallArgs args(tokens, tokens[index]);
+        size_t close = matchingParen(tokens, index + 1);
+        size_t argStart = index + 2;
+        int depth = 0;
+        for (size_t i = argStart; i < close; ++i) {
+            TokenType tt = tokens[i].type;
+            if (tt == TokenType::LPAREN || tt == TokenType::LBRACKET || tt == TokenType::LBRACE) depth++;
+            else if (tt == TokenType::RPAREN || tt == TokenType::RBRACKET || tt == TokenType::RBRACE) depth--;
+            else if (tt == TokenType::COMMA && depth == 0) {
+                args.ranges.emplace_back(argStart, i);
+                argStart = i + 1;
+            }
+        }
+        if (close > argStart || !args.ranges.empty()) {
+            args.ranges.emplace_back(argStart, close);
+        }
+        for (const auto& r : args.ranges) {
+            if (r.first == r.second) {
+                error(filename, tokens[r.first].line, tokens[r.first].col, "函数参数不能为空");
+            }
+        }
+        index = close + 1;
+        Builtin fn = builtinTable().at(args.callee.lexeme);
+        return (this->*fn)(args);
+    }
+
+    
+    void expectArgs(CallArgs& args, size_t minCount, size_t maxCount) {
+        if (args.size() < minCount || args.size() > maxCount) {
+            std::string expected = minCount == maxCount ? std::to_string(minCount)
+                : maxCount == SIZE_MAX ? "至少 " + std::to_string(minCount)
+                : std::to_string(minCount) + "~" + std::to_string(maxCount);
+            error(filename, args.callee.line, args.callee.col,
+                  "函数 \'" + args.callee.lexeme + "\' 需要 " + expected + " 个参数，实际 " +
+                  std::to_string(args.size()) + " 个");
+        }
+    }
+
+    
+    Variable evaluateValue(const std::vector<Token>& tokens, size_t b, size_t e) {
+        const Token& t = tokens[b];
+        if (e - b == 1 && t.type == TokenType::STRING) {
+            return Variable(VarType::STRING, t.lexeme);
+        }
+        if (e - b == 1 && t.type == TokenType::NUMBER) {
+            return Variable(VarType::OMNI, t.lexeme);
+        }
+        if (e - b == 1 && t.type == TokenType::IDENTIFIER) {
+            auto it = vars.find(t.lexeme);
+            if (it == vars.end()) {
+                error(filename, t.line, t.col, "未声明的变量 \'" + t.lexeme + "\'");
+            }
+            return it->second;
+        }
+        if (isBuiltinCall(tokens, b) && matchingParen(tokens, b + 1) + 1 == e) {
+            size_t idx = b;
+            return callBuiltin(tokens, idx);
+        }
+        if (t.type == TokenType::LBRACE) {
+            size_t idx = b;
+            Variable literal(VarType::ARRAY);
+            parseArrayLiteral(tokens, idx, literal);
+            if (idx != e) {
+                error(filename, tokens[idx].line, tokens[idx].col, "数组字面量之后不能有其他内容");
+            }
+            return literal;
+        }
+        if (isRecordRef(tokens, b)) {
+            size_t idx = b;
+            FieldRef ref = parseFieldRef(tokens, idx, true);
+            if (idx == e) {
+                if (!ref.column) return ref.row == SIZE_MAX ? *ref.owner : recordRow(ref);
+                return ref.column->numeric ? Variable(VarType::DOUBLE, ref.column->textAt(ref.row))
+                                           : Variable(VarType::STRING, ref.column->texts[ref.row]);
+            }
+        }
+        if (isIndexedSpan(tokens, b, e)) {
+            size_t idx = b;
+            return indexedValue(tokens, idx);
+        }
+        size_t idx = b;
+        double v = parseExpression(tokens, idx);
+        if (idx != e) {
+            error(filename, tokens[idx].line, tokens[idx].col, "表达式格式错误");
+        }
+        return Variable(VarType::DOUBLE, doubleToString(v));
+    }
+
+    
+    Variable argValue(CallArgs& args, size_t i) {
+        return evaluateValue(args.tokens, args.ranges[i].first, args.ranges[i].second);
+    }
+
+    
+    void storeElement(Variable& arr, size_t phys, const std::vector<Token>& tokens,
+                      size_t b, size_t e, const Token& target) {
+        const Token& t = tokens[b];
+        if (e - b == 1 && t.type == TokenType::NUMBER && arr.store->numeric) {
+            arr.store->setNumber(phys, stringToDouble(t.lexeme));
+            return;
+        }
+        if (arr.store->numeric && !isBuiltinCall(tokens, b) &&
+            !(e - b == 1 && t.type != TokenType::NUMBER) && !isIndexedSpan(tokens, b, e)) {
+            size_t idx = b;
+            double v = parseExpression(tokens, idx);
+            if (idx != e) {
+                error(filename, tokens[idx].line, tokens[idx].col, "表达式格式错误");
+            }
+            arr.store->setNumber(phys, v);
+            return;
+        }
+        Variable val = evaluateValue(tokens, b, e);
+        if (val.isArray()) {
+            error(filename, target.line, target.col, "不能把数组赋值给单个数组元素");
+        }
+        arr.setPhysical(phys, val);
+    }
+
+    
+    DictKey dictScalar(const Variable& v, const Token& at) {
+        if (v.isArray() || v.isDict()) {
+            error(filename, at.line, at.col, "字典的键和值只能是数字或字符串");
+        }
+        DictKey k;
+        if (v.type != VarType::STRING && parseNumber(v.value, k.num)) return k;
+        k.numeric = false;
+        k.num = 0.0;
+        k.text = v.value;
+        return k;
+    }
+
+    
+    Variable dictValueVar(const DictKey& v) {
+        return v.numeric ? Variable(VarType::DOUBLE, formatNumber(v.num)) : Variable(VarType::STRING, v.text);
+    }
+
+    
+    DictKey parseDictKey(const std::vector<Token>& tokens, size_t& index) {
+        const Token& open = tokens[index];
+        size_t close = index;
+        int depth = 0;
+        for (; close < tokens.size(); ++close) {
+            if (tokens[close].type == TokenType::LBRACKET) depth++;
+            else if (tokens[close].type == TokenType::RBRACKET && --depth == 0) break;
+        }
+        if (close >= tokens.size() || close == index + 1) {
+            error(filename, open.line, open.col, "字典下标缺少键或闭合方括号 \']\'");
+        }
+        DictKey key = dictScalar(evaluateValue(tokens, index + 1, close), open);
+        index = close + 1;
+        return key;
+    }
+
+    
+    const DictKey& dictEntry(const Variable& d, const std::vector<Token>& tokens, size_t& index, const Token& at) {
+        DictKey key = parseDictKey(tokens, index);
+        const DictKey* value = d.dict->find(key);
+        if (!value) {
+            error(filename, at.line, at.col, "字典 \'" + at.lexeme + "\' 中不存在键 \'" + key.toString() + "\'");
+        }
+        return *value;
+    }
+
+    
+    bool parseDictDeclaration(const std::vector<Token>& tokens, size_t& ip) {
+        const Token& t = tokens[ip];
+        if (ip + 2 >= tokens.size() || tokens[ip+1].type != TokenType::IDENTIFIER) {
+            error(filename, t.line, t.col, "create.dict 语法错误，应为 create.dict 名称; 或 create.dict 名称 = {键: 值, ...};");
+        }
+        const std::string& name = tokens[ip+1].lexeme;
+        Variable d(VarType::DICT, "");
+        d.dict = std::make_shared<DictStore>();
+        size_t cur = ip + 2;
+        if (tokens[cur].type == TokenType::ASSIGN) {
+            cur++;
+            if (cur < tokens.size() && tokens[cur].type == TokenType::LBRACE) {
+                cur++;
+                while (cur < tokens.size() && tokens[cur].type != TokenType::RBRACE) {
+                    size_t colon = cur;
+                    while (colon < tokens.size() && tokens[colon].type != TokenType::COLON &&
+                           tokens[colon].type != TokenType::RBRACE) colon++;
+                    size_t end = colon + 1;
+                    int depth = 0;
+                    while (end < tokens.size()) {
+                        TokenType tt = tokens[end].type;
+                        if (tt == TokenType::LPAREN || tt == TokenType::LBRACKET) depth++;
+                        else if (tt == TokenType::RPAREN || tt == TokenType::RBRACKET) depth--;
+                        else if (depth == 0 && (tt == TokenType::COMMA || tt == TokenType::RBRACE)) break;
+                        end++;
+                    }
+                    if (colon >= tokens.size() || tokens[colon].type != TokenType::COLON ||
+                        colon == cur || end == colon + 1 || end >= tokens.size()) {
+                        error(filename, tokens[cur].line, tokens[cur].col, "字典初始化项必须是 键: 值");
+                    }
+                    DictKey key = dictScalar(evaluateValue(tokens, cur, colon), tokens[cur]);
+                    d.dict->insert(key) = dictScalar(evaluateValue(tokens, colon + 1, end), tokens[colon]);
+                    cur = end;
+                    if (tokens[cur].type == TokenType::COMMA) cur++;
+                }
+                if (cur >= tokens.size()) {
+                    error(filename, t.line, t.col, "字典初始化缺少 \'}\'");
+                }
+                cur++;
+            } else {
+                size_t end = cur;
+                while (end < tokens.size() && tokens[end].type != TokenType::SEMICOLON) end++;
+                if (end == cur || end >= tokens.size()) {
+                    error(filename, t.line, t.col, "create.dict 缺少初始值");
+                }
+                Variable src = evaluateValue(tokens, cur, end);
+                if (!src.isDict()) {
+                    error(filename, t.line, t.col, "create.dict 的初始值必须是字典");
+                }
+                d.dict = std::make_shared<DictStore>(*src.dict);
+                cur = end;
+            }
+        }
+        if (cur >= tokens.size() || tokens[cur].type != TokenType::SEMICOLON) {
+            error(filename, t.line, t.col, "create.dict 语句缺少分号");
+        }
+        vars[name] = d;
+        ip = cur + 1;
+        return true;
+    }
+
+    
+    struct FieldRef {
+        const Variable* owner = nullptr;
+        ArrayStore* column = nullptr;
+        size_t row = 0;
+    };
+
+    
+    bool isRecordRef(const std::vector<Token>& tokens, size_t index) {
+        if (index + 1 >= tokens.size() || tokens[index].type != TokenType::IDENTIFIER ||
+            (tokens[index+1].type != TokenType::DOT && tokens[index+1].type != TokenType::LBRACKET)) {
+            return false;
+        }
+        auto it = vars.find(tokens[index].lexeme);
+        return it != vars.end() && it->second.isRecord();
+    }
+
+    
+    FieldRef parseFieldRef(const std::vector<Token>& tokens, size_t& index, bool allowWhole = false) {
+        const Token& at = tokens[index];
+        FieldRef ref;
+        ref.owner = &vars.find(at.lexeme)->second;
+        const Variable& rec = *ref.owner;
+        index++;
+        ref.row = rec.offset;
+        if (index < tokens.size() && tokens[index].type == TokenType::LBRACKET) {
+            if (rec.dims.empty()) {
+                error(filename, at.line, at.col, "记录 \'" + at.lexeme + "\' 不是记录数组，不能使用下标");
+            }
+            index++;
+            size_t row = subscriptValue(tokens, index);
+            if (index >= tokens.size() || tokens[index].type != TokenType::RBRACKET) {
+                error(filename, at.line, at.col, "缺少闭合方括号 \']\'");
+            }
+            index++;
+            if (row >= rec.dims[0]) {
+                error(filename, at.line, at.col, "记录数组索引越界: " + at.lexeme + "[" + std::to_string(row) + "]");
+            }
+            ref.row = row;
+        } else if (!rec.dims.empty()) {
+            if (allowWhole && (index >= tokens.size() || tokens[index].type != TokenType::DOT)) {
+                ref.row = SIZE_MAX;
+                return ref;
+            }
+            error(filename, at.line, at.col, "记录数组 \'" + at.lexeme + "\' 访问字段前需要下标");
+        }
+        if (index >= tokens.size() || tokens[index].type != TokenType::DOT) {
+            if (allowWhole) return ref;
+            error(filename, at.line, at.col, "记录 \'" + at.lexeme + "\' 缺少字段名");
+        }
+        index++;
+        if (index >= tokens.size() || tokens[index].type != TokenType::IDENTIFIER) {
+            error(filename, at.line, at.col, "记录 \'" + at.lexeme + "\' 缺少字段名");
+        }
+        const Token& field = tokens[index];
+        size_t slot = rec.records->layout->fieldIndex(field);
+        if (slot == SIZE_MAX) {
+            error(filename, field.line, field.col,
+                  "记录类型 \'" + rec.records->layout->name + "\' 没有字段 \'" + field.lexeme + "\'");
+        }
+        index++;
+        ref.column = rec.records->columns[slot].get();
+        return ref;
+    }
+
+    
+    Variable recordRow(const FieldRef& ref) {
+        Variable row(VarType::RECORD, "");
+        row.records = ref.owner->records;
+        row.offset = ref.row;
+        return row;
+    }
+
+    
+    bool parseRecordDeclaration(const std::vector<Token>& tokens, size_t& ip) {
+        const Token& t = tokens[ip];
+        if (ip + 2 >= tokens.size() || tokens[ip+1].type != TokenType::IDENTIFIER) {
+            error(filename, t.line, t.col, "create.record 语法错误");
+        }
+        const std::string& name = tokens[ip+1].lexeme;
+
+        if (tokens[ip+2].type == TokenType::LBRACE) {
+            auto layout = std::make_shared<RecordLayout>();
+            layout->name = name;
+            size_t cur = ip + 3;
+            while (cur < tokens.size() && tokens[cur].type != TokenType::RBRACE) {
+                if (tokens[cur].type == TokenType::IDENTIFIER) {
+                    if (std::find(layout->fields.begin(), layout->fields.end(), tokens[cur].lexeme) != layout->fields.end()) {
+                        error(filename, tokens[cur].line, tokens[cur].col, "记录字段重复: " + tokens[cur].lexeme);
+                    }
+                    layout->fields.push_back(tokens[cur].lexeme);
+                } else if (tokens[cur].type != TokenType::COMMA && tokens[cur].type != TokenType::SEMICOLON) {
+                    error(filename, tokens[cur].line, tokens[cur].col, "记录字段必须是标识符");
+                }
+                cur++;
+            }
+            if (cur >= tokens.size()) {
+                error(filename, t.line, t.col, "create.record 缺少闭合的 }");
+            }
+            if (layout->fields.empty()) {
+                error(filename, t.line, t.col, "记录类型 \'" + name + "\' 至少需要一个字段");
+            }
+            recordTypes[name] = layout;
+            cur++;
+            if (cur < tokens.size() && tokens[cur].type == TokenType::SEMICOLON) cur++;
+            ip = cur;
+            return true;
+        }
+
+        if (tokens[ip+2].type != TokenType::ASSIGN || ip + 3 >= tokens.size() ||
+            tokens[ip+3].type != TokenType::IDENTIFIER) {
+            error(filename, t.line, t.col, "create.record 语法错误，应为 create.record 名称 = 类型; 或 类型[数量];");
+        }
+        if (isBuiltinCall(tokens, ip + 3)) {
+            size_t end = ip + 3;
+            while (end < tokens.size() && tokens[end].type != TokenType::SEMICOLON) end++;
+            if (end >= tokens.size()) {
+                error(filename, t.line, t.col, "create.record 语句缺少分号");
+            }
+            Variable init = evaluateValue(tokens, ip + 3, end);
+            if (!init.isRecord()) {
+                error(filename, tokens[ip+3].line, tokens[ip+3].col, "create.record 的初始值必须是记录");
+            }
+            vars[name] = init;
+            ip = end + 1;
+            return true;
+        }
+        const Token& typeTok = tokens[ip+3];
+        auto layoutIt = recordTypes.find(typeTok.lexeme);
+        if (layoutIt == recordTypes.end()) {
+            error(filename, typeTok.line, typeTok.col, "未定义的记录类型 \'" + typeTok.lexeme + "\'");
+        }
+        size_t cur = ip + 4;
+        Variable rec(VarType::RECORD, "");
+        if (cur < tokens.size() && tokens[cur].type == TokenType::LBRACKET) {
+            cur++;
+            size_t count = subscriptValue(tokens, cur);
+            if (cur >= tokens.size() || tokens[cur].type != TokenType::RBRACKET) {
+                error(filename, t.line, t.col, "缺少闭合方括号 \']\'");
+            }
+            cur++;
+            rec.dims = {count};
+            rec.records = std::make_shared<RecordStore>(layoutIt->second, count);
+        } else {
+            rec.records = std::make_shared<RecordStore>(layoutIt->second, 1);
+        }
+        if (cur >= tokens.size() || tokens[cur].type != TokenType::SEMICOLON) {
+            error(filename, t.line, t.col, "create.record 语句缺少分号");
+        }
+        vars[name] = rec;
+        ip = cur + 1;
+        return true;
+    }
+
+    
+    bool parseHeapDeclaration(const std::vector<Token>& tokens, size_t& ip) {
+        const Token& t = tokens[ip];
+        if (ip + 2 >= tokens.size() || tokens[ip+1].type != TokenType::IDENTIFIER) {
+            error(filename, t.line, t.col, "create.heap 语法错误，应为 create.heap 名称; 或 create.heap 名称 = \"max\";");
+        }
+        const std::string& name = tokens[ip+1].lexeme;
+        Variable h(VarType::HEAP, "");
+        h.heap = std::make_shared<HeapStore>();
+        size_t cur = ip + 2;
+        if (tokens[cur].type == TokenType::ASSIGN) {
+            size_t end = cur + 1;
+            while (end < tokens.size() && tokens[end].type != TokenType::SEMICOLON) end++;
+            if (end == cur + 1 || end >= tokens.size()) {
+                error(filename, t.line, t.col, "create.heap 缺少初始值");
+            }
+            Variable init = evaluateValue(tokens, cur + 1, end);
+            if (init.isHeap()) {
+                h.heap = init.heap.use_count() > 1 ? std::make_shared<HeapStore>(*init.heap) : init.heap;
+            } else if (init.type == VarType::STRING && (init.value == "min" || init.value == "max")) {
+                h.heap->maxHeap = init.value == "max";
+            } else {
+                error(filename, tokens[cur+1].line, tokens[cur+1].col,
+                      "create.heap 的初始值必须是 \"min\"、\"max\" 或优先队列");
+            }
+            cur = end;
+        }
+        if (cur >= tokens.size() || tokens[cur].type != TokenType::SEMICOLON) {
+            error(filename, t.line, t.col, "create.heap 语句缺少分号");
+        }
+        vars[name] = h;
+        ip = cur + 1;
+        return true;
+    }
+
+    
+    Variable& arrayVar(const std::string& name, const Token& at) {
+        auto it = vars.find(name);
+        if (it == vars.end()) {
+            error(filename, at.line, at.col, "未声明的数组 \'" + name + "\'");
+        }
+        if (!it->second.isArray()) {
+            error(filename, at.line, at.col, "变量 \'" + name + "\' 不是数组类型");
+        }
+        return it->second;
+    }
+
+    
+    size_t subscriptValue(const std::vector<Token>& tokens, size_t& index) {
+        const Token& at = tokens[index];
+        double v = parseExpression(tokens, index);
+        if (v < 0 || v != static_cast<long long>(v)) {
+            error(filename, at.line, at.col, "数组索引必须是正整数");
+        }
+        return static_cast<size_t>(v);
+    }
+
+    
+    std::vector<Subscript> parseSubscripts(const std::vector<Token>& tokens, size_t& index) {
+        std::vector<Subscript> subs;
+        while (index < tokens.size() && tokens[index].type == TokenType::LBRACKET) {
+            const Token& open = tokens[index];
+            index++;
+            Subscript sub;
+            if (index < tokens.size() && tokens[index].type != TokenType::COLON) {
+                sub.lo = subscriptValue(tokens, index);
+                sub.hasLo = true;
+            }
+            if (index < tokens.size() && tokens[index].type == TokenType::COLON) {
+                sub.range = true;
+                index++;
+                if (index < tokens.size() && tokens[index].type != TokenType::COLON &&
+                    tokens[index].type != TokenType::RBRACKET) {
+                    sub.hi = subscriptValue(tokens, index);
+                    sub.hasHi = true;
+                }
+                if (index < tokens.size() && tokens[index].type == TokenType::COLON) {
+                    index++;
+                    sub.step = subscriptValue(tokens, index);
+                    if (sub.step == 0) {
+                        error(filename, open.line, open.col, "切片步长必须大于 0");
+                    }
+                }
+            }
+            if (index >= tokens.size() || tokens[index].type != TokenType::RBRACKET) {
+                const Token& at = tokens[std::min(index, tokens.size() - 1)];
+                error(filename, at.line, at.col, "缺少闭合方括号 \']\'");
+            }
+            index++;
+            subs.push_back(sub);
+        }
+        return subs;
+    }
+
+    
+    size_t subscriptsEnd(const std::vector<Token>& tokens, size_t index) {
+        while (index < tokens.size() && tokens[index].type == TokenType::LBRACKET) {
+            int depth = 0;
+            for (; index < tokens.size(); ++index) {
+                if (tokens[index].type == TokenType::LBRACKET) depth++;
+                else if (tokens[index].type == TokenType::RBRACKET && --depth == 0) break;
+            }
+            index++;
+        }
+        return index;
+    }
+
+    
+    bool isIndexedSpan(const std::vector<Token>& tokens, size_t b, size_t e) {
+        return b + 1 < e && tokens[b].type == TokenType::IDENTIFIER &&
+               tokens[b+1].type == TokenType::LBRACKET && subscriptsEnd(tokens, b + 1) == e;
+    }
+
+    
+    bool isElementAccess(const Variable& arr, const std::vector<Subscript>& subs) {
+        if (subs.size() != arr.dims.size()) return false;
+        for (const Subscript& sub : subs) {
+            if (sub.range) return false;
+        }
+        return true;
+    }
+
+    
+    size_t elementOffset(const Variable& arr, const std::vector<Subscript>& subs, const Token& at) {
+        size_t phys = arr.offset;
+        for (size_t k = 0; k < subs.size(); ++k) {
+            if (subs[k].lo >= arr.dims[k]) {
+                error(filename, at.line, at.col,
+                      "数组索引越界: " + at.lexeme + "[" + std::to_string(subs[k].lo) + "]");
+            }
+            phys += subs[k].lo * arr.strides[k];
+        }
+        return phys;
+    }
+
+    
+    Variable sliceVar(const Variable& arr, const std::vector<Subscript>& subs, const Token& at) {
+        if (subs.size() > arr.dims.size()) {
+            error(filename, at.line, at.col, "维度不匹配: " + at.lexeme);
+        }
+        try {
+            return arr.slice(subs);
+        } catch (const std::exception& e) {
+            error(filename, at.line, at.col, std::string(e.what()) + ": " + at.lexeme);
+        }
+        return arr;
+    }
+
+    
+    size_t scanSubscripts(const std::vector<Token>& tokens, size_t index, size_t& count, bool& hasRange) {
+        count = 0;
+        hasRange = false;
+        while (index < tokens.size() && tokens[index].type == TokenType::LBRACKET) {
+            int depth = 0;
+            for (; index < tokens.size(); ++index) {
+                TokenType tt = tokens[index].type;
+                if (tt == TokenType::LBRACKET) depth++;
+                else if (tt == TokenType::RBRACKET && --depth == 0) break;
+                else if (tt == TokenType::COLON && depth == 1) hasRange = true;
+            }
+            index++;
+            count++;
+        }
+        return index;
+    }
+
+    
+    bool isElementSubscripts(const std::vector<Token>& tokens, size_t index, const Variable& arr) {
+        size_t count;
+        bool hasRange;
+        scanSubscripts(tokens, index, count, hasRange);
+        return !hasRange && count == arr.dims.size();
+    }
+
+    
+    size_t parseElementOffset(const std::vector<Token>& tokens, size_t& index, const Variable& arr,
+                              const Token& at) {
+        const size_t rank = arr.dims.size();
+        const size_t* dims = arr.dims.data();
+        const size_t* strides = arr.strides.data();
+        size_t phys = arr.offset;
+        for (size_t k = 0; k < rank; ++k) {
+            index++;
+            size_t i = subscriptValue(tokens, index);
+            if (index >= tokens.size() || tokens[index].type != TokenType::RBRACKET) {
+                const Token& bad = tokens[std::min(index, tokens.size() - 1)];
+                error(filename, bad.line, bad.col, "缺少闭合方括号 \']\'");
+            }
+            index++;
+            if (i >= dims[k]) {
+                error(filename, at.line, at.col,
+                      "数组索引越界: " + at.lexeme + "[" + std::to_string(i) + "]");
+            }
+            phys += i * strides[k];
+        }
+        return phys;
+    }
+
+    
+    Variable indexedValue(const std::vector<Token>& tokens, size_t& index) {
+        const Token& at = tokens[index];
+        index++;
+        auto dictIt = vars.find(at.lexeme);
+        if (dictIt != vars.end() && dictIt->second.isDict()) {
+            return dictValueVar(dictEntry(dictIt->second, tokens, index, at));
+        }
+        Variable& arr = arrayVar(at.lexeme, at);
+        if (isElementSubscripts(tokens, index, arr)) {
+            size_t phys = parseElementOffset(tokens, index, arr, at);
+            return Variable(arr.store->numeric ? VarType::OMNI : VarType::STRING, arr.store->textAt(phys));
+        }
+        std::vector<Subscript> subs = parseSubscripts(tokens, index);
+        if (isElementAccess(arr, subs)) {
+            return Variable(arr.store->numeric ? VarType::OMNI : VarType::STRING,
+                            arr.store->textAt(elementOffset(arr, subs, at)));
+        }
+        return sliceVar(arr, subs, at);
+    }
+
+    
+    Variable argArray(CallArgs& args, size_t i) {
+        Variable v = argValue(args, i);
+        expectArray(args, i, v);
+        return v;
+    }
+
+    
+    void expectArray(CallArgs& args, size_t i, const Variable& v) {
+        if (!v.isArray()) {
+            const Token& t = args.tokens[args.ranges[i].first];
+            error(filename, t.line, t.col,
+                  "函数 \'" + args.callee.lexeme + "\' 的第 " + std::to_string(i + 1) + " 个参数必须是数组");
+        }
+    }
+
+    
+    double argNumber(CallArgs& args, size_t i) {
+        size_t b = args.ranges[i].first, e = args.ranges[i].second;
+        size_t idx = b;
+        double v = parseExpression(args.tokens, idx);
+        if (idx != e) {
+            error(filename, args.tokens[idx].line, args.tokens[idx].col,
+                  "函数 \'" + args.callee.lexeme + "\' 的参数表达式格式错误");
+        }
+        return v;
+    }
+
+    
+    std::string argText(CallArgs& args, size_t i) {
+        return argValue(args, i).displayString();
+    }
+
+    
+    SumMode argSumMode(CallArgs& args, size_t i) {
+        if (i >= args.size()) return SumMode::FAST;
+        std::string mode = argText(args, i);
+        if (mode == "kahan") return SumMode::KAHAN;
+        if (mode == "pairwise") return SumMode::PAIRWISE;
+        if (mode != "fast") {
+            const Token& t = args.tokens[args.ranges[i].first];
+            error(filename, t.line, t.col, "未知的求和模式 \'" + mode + "\'，可选 fast、kahan、pairwise");
+        }
+        return SumMode::FAST;
+    }
+
+    
+    void assignResult(const std::string& name, const Token& at, Variable result, bool share = false) {
+        auto it = vars.find(name);
+        if (it == vars.end()) {
+            error(filename, at.line, at.col, "变量 \'" + name + "\' 未声明，不能赋值");
+        }
+        if (result.isDict() || it->second.isDict()) {
+            if (!result.isDict() || !it->second.isDict()) {
+                error(filename, at.line, at.col, "字典 \'" + name + "\' 只能与字典互相赋值");
+            }
+            if (!share && result.dict.use_count() > 1) {
+                result.dict = std::make_shared<DictStore>(*result.dict);
+            }
+            it->second = result;
+            return;
+        }
+        if (result.isIndex() || it->second.isIndex()) {
+            if (!result.isIndex() || (!it->second.isIndex() && it->second.type != VarType::OMNI)) {
+                error(filename, at.line, at.col, "排序索引只能保存到 omni 变量或另一个排序索引中");
+            }
+            it->second = result;
+            return;
+        }
+        if (result.isDigest() || it->second.isDigest()) {
+            if (!result.isDigest() || (!it->second.isDigest() && it->second.type != VarType::OMNI)) {
+                error(filename, at.line, at.col, "tdigest 只能保存到 omni 变量或另一个 tdigest 中");
+            }
+            if (!share && result.digest.use_count() > 1) {
+                result.digest = std::make_shared<TDigest>(*result.digest);
+            }
+            it->second = result;
+            return;
+        }
+        if (result.isCsv() || it->second.isCsv()) {
+            if (!result.isCsv() || (!it->second.isCsv() && it->second.type != VarType::OMNI)) {
+                error(filename, at.line, at.col, "CSV 读取器只能保存到 omni 变量或另一个 CSV 读取器中");
+            }
+            it->second = result;
+            return;
+        }
+        if (result.isRecord() || it->second.isRecord()) {
+            if (!result.isRecord() || !it->second.isRecord()) {
+                error(filename, at.line, at.col, "记录 \'" + name + "\' 只能与记录互相赋值");
+            }
+            if (!share && result.records.use_count() > 1) {
+                auto copy = std::make_shared<RecordStore>(*result.records);
+                for (auto& column : copy->columns) column = std::make_shared<ArrayStore>(*column);
+                result.records = copy;
+            }
+            it->second = result;
+            return;
+        }
+        if (result.isHeap() || it->second.isHeap()) {
+            if (!result.isHeap() || !it->second.isHeap()) {
+                error(filename, at.line, at.col, "优先队列 \'" + name + "\' 只能与优先队列互相赋值");
+            }
+            if (!share && result.heap.use_count() > 1) {
+                result.heap = std::make_shared<HeapStore>(*result.heap);
+            }
+            it->second = result;
+            return;
+        }
+        if (result.isArray()) {
+            if (!it->second.isArray()) {
+                error(filename, at.line, at.col, "变量 \'" + name + "\' 不是数组类型，不能接收数组结果");
+            }
+            it->second = (share || result.store.use_count() == 1) ? result : result.clone();
+            return;
+        }
+        if (it->second.isArray()) {
+            error(filename, at.line, at.col, "数组 \'" + name + "\' 不能接收标量结果");
+        }
+        if (it->second.type != VarType::STRING && result.type == VarType::STRING) {
+            error(filename, at.line, at.col, "变量 \'" + name + "\' 是数值类型，不能接收字符串结果");
+        }
+        it->second.value = result.value;
+    }
+
+    
+    void parseArrayLiteral(const std::vector<Token>& tokens, size_t& ip, Variable& out) {
+        if (tokens[ip].type != TokenType::LBRACE) {
+            error(filename, tokens[ip].line, tokens[ip].col, "数组初始化缺少 \'{\'");
+        }
+        std::shared_ptr<ArrayStore> store = std::make_shared<ArrayStore>();
+        std::vector<size_t> shape;
+        std::vector<size_t> counts;
+        size_t leafDepth = SIZE_MAX;
+
+        size_t capacity = 0;
+        int braceDepth = 0;
+        for (size_t i = ip; i < tokens.size(); ++i) {
+            TokenType tt = tokens[i].type;
+            if (tt == TokenType::LBRACE) braceDepth++;
+            else if (tt == TokenType::RBRACE && --braceDepth == 0) break;
+            else if (tt == TokenType::NUMBER || tt == TokenType::STRING || tt == TokenType::IDENTIFIER) capacity++;
+        }
+        store->nums.reserve(capacity);
+
+        auto appendNumber = [&](double v) {
+            if (store->numeric) store->nums.push_back(v);
+            else store->texts.push_back(formatNumber(v));
+        };
+        auto appendText = [&](const std::string& text) {
+            if (store->numeric) {
+                store->toText();
+                store->texts.reserve(capacity);
+            }
+            store->texts.push_back(text);
+        };
+
+        while (true) {
+            if (ip >= tokens.size()) {
+                const Token& last = tokens.back();
+                error(filename, last.line, last.col, "数组初始化缺少 \'}\'");
+            }
+            const Token& t = tokens[ip];
+            size_t depth = counts.size();
+
+            if (t.type == TokenType::LBRACE) {
+                if (depth > 0) {
+                    if (depth >= leafDepth) {
+                        error(filename, t.line, t.col, "多维数组各维度大小不一致");
+                    }
+                    counts.back()++;
+                }
+                counts.push_back(0);
+                ip++;
+                continue;
+            }
+
+            if (t.type == TokenType::RBRACE) {
+                if (depth == 0) {
+                    error(filename, t.line, t.col, "数组初始化多余的 \'}\'");
+                }
+                size_t count = counts.back();
+                counts.pop_back();
+                if (shape.size() < depth) {
+                    shape.resize(depth, SIZE_MAX);
+                }
+                if (shape[depth-1] == SIZE_MAX) {
+                    shape[depth-1] = count;
+                } else if (shape[depth-1] != count) {
+                    error(filename, t.line, t.col, "多维数组各维度大小不一致");
+                }
+                ip++;
+                if (counts.empty()) break;
+            } else {
+                if (depth == 0) {
+                    error(filename, t.line, t.col, "数组初始化缺少 \'{\'");
+                }
+                if (leafDepth == SIZE_MAX) {
+                    leafDepth = depth;
+                } else if (leafDepth != depth) {
+                    error(filename, t.line, t.col, "多维数组各维度大小不一致");
+                }
+
+                bool negative = false;
+                size_t at = ip;
+                if ((t.type == TokenType::MINUS || t.type == TokenType::PLUS) &&
+                    ip + 1 < tokens.size() && tokens[ip+1].type == TokenType::NUMBER) {
+                    negative = t.type == TokenType::MINUS;
+                    at = ip + 1;
+                }
+                const Token& v = tokens[at];
+                if (v.type == TokenType::NUMBER) {
+                    double num;
+                    if (!parseNumber(v.lexeme, num)) num = stringToDouble(v.lexeme);
+                    appendNumber(negative ? -num : num);
+                } else if (v.type == TokenType::STRING) {
+                    appendText(v.lexeme);
+                } else if (v.type == TokenType::IDENTIFIER) {
+                    auto it = vars.find(v.lexeme);
+                    if (it == vars.end()) {
+                        error(filename, v.line, v.col, "变量 \'" + v.lexeme + "\' 未声明");
+                    }
+                    if (it->second.isArray()) {
+                        error(filename, v.line, v.col, "数组元素不能是数组 \'" + v.lexeme + "\'");
+                    }
+                    double num;
+                    if (it->second.type != VarType::STRING && parseNumber(it->second.value, num)) {
+                        appendNumber(num);
+                    } else {
+                        appendText(it->second.value);
+                    }
+                } else {
+                    error(filename, v.line, v.col, "数组元素必须是数字、字符串或标识符");
+                }
+                counts.back()++;
+                ip = at + 1;
+            }
+
+            if (ip < tokens.size() && tokens[ip].type == TokenType::COMMA) {
+                ip++;
+            }
+        }
+
+        for (size_t& d : shape) {
+            if (d == SIZE_MAX) d = 0;
+        }
+        out.type = VarType::ARRAY;
+        out.dims = shape;
+        out.strides = Variable::rowMajorStrides(shape);
+        out.offset = 0;
+        out.store = store;
+    }
+
+    
+    void loadLibrary(const std::string& libName) {
+        std::string libFilename = libName;
+        if (libFilename.find('.') == std::string::npos) {
+            libFilename += ".lib";
+        }
+        std::ifstream libFile(libFilename);
+        if (!libFile.is_open()) {
+            error(filename, 0, 0, "无法打开库文件 \'" + libFilename + "\'");
+            return;
+        }
+        std::string libSrc((std::istreambuf_iterator<char>(libFile)),
+                          std::istreambuf_iterator<char>());
+        libFile.close();
+        Scanner libScanner(libSrc, libFilename);
+        auto libTokens = libScanner.scan();
+        execute(libTokens);
+    }
+
+    
+    std::string evaluateTernary(const std::vector<Token>& tokens, size_t& index) {
+        if (tokens[index].type != TokenType::IDENTIFIER) {
+            error(filename, tokens[index].line, tokens[index].col,
+                  "三元运算符条件必须是标识符");
+        }
+        std::string condVar = tokens[index].lexeme;
+        double condValue = getNumericVar(condVar);
+        index++;
+        if (index >= tokens.size() || tokens[index].type != TokenType::QUESTION) {
+            error(filename, tokens[index].line, tokens[index].col,
+                  "三元表达式缺少问号");
+        }
+        index++;
+        std::string trueValue;
+        if (tokens[index].type == TokenType::STRING) {
+            trueValue = tokens[index].lexeme;
+            index++;
+        } else if (tokens[index].type == TokenType::NUMBER) {
+            trueValue = tokens[index].lexeme;
+            index++;
+        } else if (tokens[index].type == TokenType::IDENTIFIER) {
+            trueValue = getVar(tokens[index].lexeme);
+            index++;
+        } else {
+            error(filename, tokens[index].line, tokens[index].col,
+                  "三元表达式真分支格式错误");
+        }
+        if (index >= tokens.size() || tokens[index].type != TokenType::COLON) {
+            error(filename, tokens[index].line, tokens[index].col,
+                  "三元表达式缺少冒号");
+        }
+        index++;
+        std::string falseValue;
+        if (tokens[index].type == TokenType::STRING) {
+            falseValue = tokens[index].lexeme;
+            index++;
+        } else if (tokens[index].type == TokenType::NUMBER) {
+            falseValue = tokens[index].lexeme;
+            index++;
+        } else if (tokens[index].type == TokenType::IDENTIFIER) {
+            falseValue = getVar(tokens[index].lexeme);
+            index++;
+        } else {
+            error(filename, tokens[index].line, tokens[index].col,
+                  "三元表达式假分支格式错误");
+        }
+        return condValue != 0 ? trueValue : falseValue;
+    }
+
+    
+    std::vector<Variable> parseArrayInitializer(const std::vector<Token>& tokens, size_t& ip) {
+        std::vector<Variable> elements;
+
+        if (tokens[ip].type != TokenType::LBRACE) {
+            error(filename, tokens[ip].line, tokens[ip].col, "数组初始化缺少 \'{\'");
+        }
+        ip++;
+
+        while (ip < tokens.size() && tokens[ip].type != TokenType::RBRACE) {
+            if (tokens[ip].type == TokenType::NUMBER) {
+                elements.push_back(Variable(VarType::OMNI, tokens[ip].lexeme));
+                ip++;
+            } else if (tokens[ip].type == TokenType::STRING) {
+                elements.push_back(Variable(VarType::STRING, tokens[ip].lexeme));
+                ip++;
+            } else if (tokens[ip].type == TokenType::IDENTIFIER) {
+                elements.push_back(Variable(VarType::OMNI, getVar(tokens[ip].lexeme)));
+                ip++;
+            } else {
+                error(filename, tokens[ip].line, tokens[ip].col, "数组元素必须是数字、字符串或标识符");
+            }
+
+            if (ip < tokens.size() && tokens[ip].type == TokenType::COMMA) {
+                ip++;
+            }
+        }
+
+        if (ip >= tokens.size() || tokens[ip].type != TokenType::RBRACE) {
+            error(filename, tokens[ip].line, tokens[ip].col, "数组初始化缺少 \'}\'");
+        }
+        ip++;
+
+        return elements;
+    }
+
+    
+    bool parseShortcutDeclaration(const std::vector<Token>& tokens, size_t& ip) {
+        TokenType declType = tokens[ip].type;
+        const Token& t = tokens[ip];
+
+        if (declType == TokenType::CREATE_SORT) {
+            if (ip + 2 >= tokens.size() || tokens[ip+1].type != TokenType::IDENTIFIER ||
+                tokens[ip+2].type != TokenType::SEMICOLON) {
+                error(filename, t.line, t.col, "create.sort 语法错误，应为 create.sort 数组名;");
+            }
+            auto it = vars.find(tokens[ip+1].lexeme);
+            if (it == vars.end() || !it->second.isArray()) {
+                error(filename, tokens[ip+1].line, tokens[ip+1].col,
+                      "create.sort 的目标 \'" + tokens[ip+1].lexeme + "\' 必须是已声明的数组");
+            }
+            it->second.sort();
+            ip += 3;
+            return true;
+        }
+
+        if (ip + 3 >= tokens.size() || tokens[ip+1].type != TokenType::IDENTIFIER ||
+            tokens[ip+2].type != TokenType::ASSIGN) {
+            error(filename, t.line, t.col, t.lexeme + " 语法错误，应为 " + t.lexeme + " 变量名 = ...;");
+        }
+        std::string name = tokens[ip+1].lexeme;
+        size_t exprEnd = ip + 3;
+        while (exprEnd < tokens.size() && tokens[exprEnd].type != TokenType::SEMICOLON) {
+            exprEnd++;
+        }
+        if (exprEnd >= tokens.size()) {
+            error(filename, t.line, t.col, t.lexeme + " 语句缺少分号");
+        }
+
+        double result = 0;
+        if (declType == TokenType::CREATE_SUM) {
+            const Token& src = tokens[ip+3];
+            auto it = vars.find(src.lexeme);
+            if (src.type != TokenType::IDENTIFIER || exprEnd != ip + 4 ||
+                it == vars.end() || !it->second.isArray()) {
+                error(filename, src.line, src.col, "create.sum 的右侧必须是已声明的数组");
+            }
+            result = it->second.sum();
+        } else {
+            size_t idx = ip + 3;
+            double operand = parseExpression(tokens, idx);
+            if (idx != exprEnd) {
+                error(filename, tokens[idx].line, tokens[idx].col, "create.sqrt 表达式格式错误");
+            }
+            if (operand < 0) {
+                error(filename, t.line, t.col, "create.sqrt 不能对负数开平方");
+            }
+            result = std::sqrt(operand);
+        }
+        setVar(name, VarType::DOUBLE, doubleToString(result));
+        ip = exprEnd + 1;
+        return true;
+    }
+
+    
+    bool parseVariableDeclaration(const std::vector<Token>& tokens, size_t& ip) {
+        TokenType declType = tokens[ip].type;
+        if (declType == TokenType::CREATE_SUM ||
+            declType == TokenType::CREATE_SQRT ||
+            declType == TokenType::CREATE_SORT) {
+            return parseShortcutDeclaration(tokens, ip);
+        }
+        if (declType == TokenType::CREATE_DICT) {
+            return parseDictDeclaration(tokens, ip);
+        }
+        if (declType == TokenType::CREATE_RECORD) {
+            return parseRecordDeclaration(tokens, ip);
+        }
+        if (declType == TokenType::CREATE_HEAP) {
+            return parseHeapDeclaration(tokens, ip);
+        }
+        if (declType != TokenType::CREATE_INT &&
+            declType != TokenType::CREATE_DOUBLE &&
+            declType != TokenType::CREATE_OMNI &&
+            declType != TokenType::CREATE_STRING &&
+            declType != TokenType::CREATE_ARR) {
+            return false;
+        }
+
+        
+        if (ip + 2 < tokens.size() &&
+            tokens[ip+1].type == TokenType::IDENTIFIER &&
+            tokens[ip+2].type == TokenType::SEMICOLON) {
+
+            if (declType == TokenType::CREATE_ARR) {
+                Variable arr(VarType::ARRAY);
+                arr.setDims({0});
+                vars[tokens[ip+1].lexeme] = arr;
+                ip += 3;
+                return true;
+            }
+
+            std::string name = tokens[ip+1].lexeme;
+            VarType type = VarType::DOUBLE;
+            if (declType == TokenType::CREATE_INT) type = VarType::INT;
+            else if (declType == TokenType::CREATE_DOUBLE) type = VarType::DOUBLE;
+            else if (declType == TokenType::CREATE_OMNI) type = VarType::OMNI;
+            else if (declType == TokenType::CREATE_STRING) type = VarType::STRING;
+
+            std::string initVal = (type == VarType::STRING) ? "" : "0";
+            setVar(name, type, initVal);
+            ip += 3;
+            return true;
+        }
+
+        
+        if (declType == TokenType::CREATE_ARR && ip + 5 < tokens.size() &&
+            tokens[ip+1].type == TokenType::IDENTIFIER &&
+            tokens[ip+2].type == TokenType::ASSIGN &&
+            tokens[ip+3].type == TokenType::LBRACE) {
+
+            size_t tempIp = ip + 3;
+            const std::string& name = tokens[ip+1].lexeme;
+            Variable arr(VarType::ARRAY);
+            parseArrayLiteral(tokens, tempIp, arr);
+
+            if (tempIp < tokens.size() && tokens[tempIp].type == TokenType::SEMICOLON) {
+                vars[name] = std::move(arr);
+                ip = tempIp + 1;
+                return true;
+            }
+        }
+
+        
+        if (declType == TokenType::CREATE_ARR && ip + 4 < tokens.size() &&
+            tokens[ip+1].type == TokenType::IDENTIFIER) {
+
+            size_t tempIp = ip + 2;
+            std::string name = tokens[ip+1].lexeme;
+            std::vector<size_t> dims;
+
+            while (tempIp < tokens.size() && tokens[tempIp].type == TokenType::LBRACKET) {
+                tempIp++;
+                if (tempIp < tokens.size() && tokens[tempIp].type == TokenType::NUMBER) {
+                    size_t size = static_cast<size_t>(stringToDouble(tokens[tempIp].lexeme));
+                    dims.push_back(size);
+                    tempIp++;
+                    if (tempIp < tokens.size() && tokens[tempIp].type == TokenType::RBRACKET) {
+                        tempIp++;
+                    } else {
+                        break;
+                    }
+                } else {
+                    break;
+                }
+            }
+
+            if (!dims.empty() && tempIp < tokens.size() && tokens[tempIp].type == TokenType::SEMICOLON) {
+                Variable arr(VarType::ARRAY);
+                try {
+                    arr.setDims(dims);
+                } catch (const std::bad_alloc&) {
+                    error(filename, tokens[ip+1].line, tokens[ip+1].col,
+                          "数组 \'" + name + "\' 过大，内存不足；稀疏数据请使用 sparse(...) 声明");
+                }
+                vars[name] = arr;
+                ip = tempIp + 1;
+                return true;
+            }
+        }
+
+        
+        if (ip + 4 < tokens.size() &&
+            tokens[ip+1].type == TokenType::IDENTIFIER &&
+            tokens[ip+2].type == TokenType::ASSIGN &&
+            (tokens[ip+3].type == TokenType::NUMBER ||
+             tokens[ip+3].type == TokenType::STRING ||
+             tokens[ip+3].type == TokenType::IDENTIFIER) &&
+            tokens[ip+4].type == TokenType::SEMICOLON) {
+
+            std::string name = tokens[ip+1].lexeme;
+            VarType type = VarType::DOUBLE;
+            if (declType == TokenType::CREATE_INT) type = VarType::INT;
+            else if (declType == TokenType::CREATE_DOUBLE) type = VarType::DOUBLE;
+            else if (declType == TokenType::CREATE_OMNI) type = VarType::OMNI;
+            else if (declType == TokenType::CREATE_STRING) type = VarType::STRING;
+
+            const Token& rightToken = tokens[ip+3];
+
+            if (rightToken.type == TokenType::NUMBER) {
+                setVar(name, type, rightToken.lexeme);
+            } else if (rightToken.type == TokenType::STRING) {
+                setVar(name, type, rightToken.lexeme);
+            } else if (rightToken.type == TokenType::IDENTIFIER) {
+                
+                if (!hasVar(rightToken.lexeme)) {
+                    error(filename, rightToken.line, rightToken.col,
+                          "赋值时右侧变量 \'" + rightToken.lexeme + "\' 未声明");
+                }
+                Variable rightVar = vars[rightToken.lexeme];
+                setVar(name, type, rightVar.scalarValue());
+            }
+            ip += 5;
+            return true;
+        }
+
+        
+        if (ip + 4 < tokens.size() &&
+            tokens[ip+1].type == TokenType::IDENTIFIER &&
+            tokens[ip+2].type == TokenType::ASSIGN) {
+            size_t exprStart = ip + 3;
+            size_t exprEnd = exprStart;
+            while (exprEnd < tokens.size() && tokens[exprEnd].type != TokenType::SEMICOLON) {
+                exprEnd++;
+            }
+            if (exprEnd < tokens.size() && tokens[exprEnd].type == TokenType::SEMICOLON) {
+                VarType type = VarType::DOUBLE;
+                if (declType == TokenType::CREATE_INT) type = VarType::INT;
+                else if (declType == TokenType::CREATE_DOUBLE) type = VarType::DOUBLE;
+                else if (declType == TokenType::CREATE_OMNI) type = VarType::OMNI;
+                else if (declType == TokenType::CREATE_STRING) type = VarType::STRING;
+
+                if (isBuiltinCall(tokens, exprStart) && matchingParen(tokens, exprStart + 1) + 1 == exprEnd) {
+                    std::string name = tokens[ip+1].lexeme;
+                    Variable declared(type, type == VarType::STRING ? "" : "0");
+                    if (declType == TokenType::CREATE_ARR) {
+                        declared = Variable(VarType::ARRAY);
+                        declared.setDims({0});
+                    }
+                    vars[name] = declared;
+                    size_t callIp = exprStart;
+                    assignResult(name, tokens[ip+1], callBuiltin(tokens, callIp));
+                    ip = exprEnd + 1;
+                    return true;
+                }
+
+                if (declType == TokenType::CREATE_ARR && isIndexedSpan(tokens, exprStart, exprEnd)) {
+                    std::string name = tokens[ip+1].lexeme;
+                    size_t viewIp = exprStart;
+                    Variable view = indexedValue(tokens, viewIp);
+                    if (!view.isArray()) {
+                        error(filename, tokens[ip].line, tokens[ip].col, "数组声明的右侧必须是数组或数组切片");
+                    }
+                    vars[name] = view;
+                    ip = exprEnd + 1;
+                    return true;
+                }
+
+                if (type == VarType::STRING) {
+                    error(filename, tokens[ip].line, tokens[ip].col,
+                          "字符串类型不支持表达式赋值");
+                } else {
+                    size_t idx = exprStart;
+                    double result = evaluateExpr(tokens, idx);
+                    setVar(tokens[ip+1].lexeme, type, doubleToString(result));
+                }
+                ip = exprEnd + 1;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    
+    bool parseAssignment(const std::vector<Token>& tokens, size_t& ip) {
+        if (parseVariableDeclaration(tokens, ip)) {
+            return true;
+        }
+
+        
+        if (isRecordRef(tokens, ip)) {
+            const Token& target = tokens[ip];
+            size_t cur = ip;
+            FieldRef ref = parseFieldRef(tokens, cur);
+            if (cur < tokens.size() && tokens[cur].type == TokenType::ASSIGN) {
+                size_t valueEnd = cur + 1;
+                while (valueEnd < tokens.size() && tokens[valueEnd].type != TokenType::SEMICOLON) valueEnd++;
+                if (valueEnd >= tokens.size() || valueEnd == cur + 1) {
+                    error(filename, target.line, target.col, "记录字段赋值缺少值或分号");
+                }
+                auto keep = ref.owner->records;
+                Variable val = evaluateValue(tokens, cur + 1, valueEnd);
+                if (val.isArray() || val.isDict() || val.isRecord()) {
+                    error(filename, target.line, target.col, "记录字段只能保存数字或字符串");
+                }
+                if (val.type == VarType::STRING) ref.column->setText(ref.row, val.value);
+                else ref.column->setValue(ref.row, val.value);
+                ip = valueEnd + 1;
+                return true;
+            }
+        }
+
+        
+        if (tokens[ip].type == TokenType::IDENTIFIER && ip + 1 < tokens.size() &&
+            tokens[ip+1].type == TokenType::LBRACKET) {
+            const Token& target = tokens[ip];
+            size_t assignAt = subscriptsEnd(tokens, ip + 1);
+            if (assignAt < tokens.size() && tokens[assignAt].type == TokenType::ASSIGN) {
+                size_t valueStart = assignAt + 1;
+                size_t valueEnd = valueStart;
+                while (valueEnd < tokens.size() && tokens[valueEnd].type != TokenType::SEMICOLON) {
+                    valueEnd++;
+                }
+
+                if (valueEnd < tokens.size() && valueEnd > valueStart) {
+                    auto dictIt = vars.find(target.lexeme);
+                    if (dictIt != vars.end() && dictIt->second.isDict()) {
+                        size_t keyIp = ip + 1;
+                        DictKey key = parseDictKey(tokens, keyIp);
+                        if (keyIp != assignAt) {
+                            error(filename, target.line, target.col, "字典只支持一层下标 " + target.lexeme + "[键]");
+                        }
+                        DictKey value = dictScalar(evaluateValue(tokens, valueStart, valueEnd), target);
+                        dictIt->second.dict->insert(key) = std::move(value);
+                        ip = valueEnd + 1;
+                        return true;
+                    }
+                    Variable& arr = arrayVar(target.lexeme, target);
+                    size_t subIp = ip + 1;
+                    if (isElementSubscripts(tokens, subIp, arr)) {
+                        size_t phys = parseElementOffset(tokens, subIp, arr, target);
+                        storeElement(arr, phys, tokens, valueStart, valueEnd, target);
+                        ip = valueEnd + 1;
+                        return true;
+                    }
+                    std::vector<Subscript> subs = parseSubscripts(tokens, subIp);
+                    Variable val = evaluateValue(tokens, valueStart, valueEnd);
+
+                    if (isElementAccess(arr, subs)) {
+                        if (val.isArray()) {
+                            error(filename, target.line, target.col, "不能把数组赋值给单个数组元素");
+                        }
+                        arr.setPhysical(elementOffset(arr, subs, target), val);
+                    } else {
+                        Variable view = sliceVar(arr, subs, target);
+                        if (!val.isArray()) {
+                            view.fill(val);
+                        } else if (val.elementCount() != view.elementCount()) {
+                            error(filename, target.line, target.col,
+                                  "切片赋值元素数量不一致，期望 " + std::to_string(view.elementCount()) +
+                                  " 个，实际 " + std::to_string(val.elementCount()) + " 个");
+                        } else {
+                            view.assignFrom(val);
+                        }
+                    }
+
+                    ip = valueEnd + 1;
+                    return true;
+                }
+            }
+        }
+
+        
+        
+        if (tokens[ip].type == TokenType::IDENTIFIER && ip + 3 < tokens.size() &&
+            tokens[ip+1].type == TokenType::ASSIGN &&
+            tokens[ip+3].type == TokenType::SEMICOLON) {
+
+            std::string leftName = tokens[ip].lexeme;
+            const Token& rightToken = tokens[ip+2];
+
+            
+            if (!hasVar(leftName)) {
+                error(filename, tokens[ip].line, tokens[ip].col,
+                      "变量 \'" + leftName + "\' 未声明，不能赋值");
+            }
+
+            
+            if (rightToken.type == TokenType::NUMBER) {
+                std::string val = rightToken.lexeme;
+                VarType type = getVarType(leftName);
+                setVar(leftName, type, val);
+                ip += 4;
+                return true;
+            }
+
+            
+            if (rightToken.type == TokenType::STRING) {
+                std::string val = rightToken.lexeme;
+                VarType type = getVarType(leftName);
+                setVar(leftName, type, val);
+                ip += 4;
+                return true;
+            }
+
+            
+            if (rightToken.type == TokenType::IDENTIFIER) {
+                std::string rightName = rightToken.lexeme;
+                if (!hasVar(rightName)) {
+                    error(filename, rightToken.line, rightToken.col,
+                          "赋值时右侧变量 \'" + rightName + "\' 未声明");
+                }
+                Variable rightVar = vars[rightName];
+                if (rightVar.isDict() || vars[leftName].isDict()) {
+                    assignResult(leftName, tokens[ip], rightVar);
+                    ip += 4;
+                    return true;
+                }
+                VarType leftType = getVarType(leftName);
+                setVar(leftName, leftType, rightVar.scalarValue());
+                ip += 4;
+                return true;
+            }
+        }
+
+        
+        if (tokens[ip].type == TokenType::IDENTIFIER && ip + 2 < tokens.size() &&
+            tokens[ip+1].type == TokenType::ASSIGN) {
+            size_t exprStart = ip + 2;
+            size_t exprEnd = exprStart;
+            while (exprEnd < tokens.size() && tokens[exprEnd].type != TokenType::SEMICOLON) {
+                exprEnd++;
+            }
+            if (exprEnd < tokens.size() && tokens[exprEnd].type == TokenType::SEMICOLON) {
+                std::string name = tokens[ip].lexeme;
+                if (!hasVar(name)) {
+                    error(filename, tokens[ip].line, tokens[ip].col,
+                          "变量 \'" + name + "\' 未声明，不能赋值表达式");
+                }
+                if (isBuiltinCall(tokens, exprStart) && matchingParen(tokens, exprStart + 1) + 1 == exprEnd) {
+                    size_t callIp = exprStart;
+                    assignResult(name, tokens[ip], callBuiltin(tokens, callIp));
+                    ip = exprEnd + 1;
+                    return true;
+                }
+                if (isArrayVar(name) && isIndexedSpan(tokens, exprStart, exprEnd)) {
+                    size_t viewIp = exprStart;
+                    assignResult(name, tokens[ip], indexedValue(tokens, viewIp), true);
+                    ip = exprEnd + 1;
+                    return true;
+                }
+                VarType type = getVarType(name);
+                if (type == VarType::STRING) {
+                    error(filename, tokens[ip].line, tokens[ip].col,
+                          "字符串类型不支持表达式赋值");
+                } else {
+                    size_t idx = exprStart;
+                    double result = evaluateExpr(tokens, idx);
+                    setVar(name, type, doubleToString(result));
+                }
+                ip = exprEnd + 1;
+                return true;
+            }
+        }
+
+        
+        if (tokens[ip].type == TokenType::IDENTIFIER && ip + 3 < tokens.size() &&
+            (tokens[ip+1].type == TokenType::PLUS_EQUALS ||
+             tokens[ip+1].type == TokenType::MINUS_EQUALS ||
+             tokens[ip+1].type == TokenType::STAR_EQUALS ||
+             tokens[ip+1].type == TokenType::SLASH_EQUALS) &&
+            (tokens[ip+2].type == TokenType::NUMBER ||
+             tokens[ip+2].type == TokenType::IDENTIFIER) &&
+            tokens[ip+3].type == TokenType::SEMICOLON) {
+            std::string varName = tokens[ip].lexeme;
+            if (!hasVar(varName)) {
+                error(filename, tokens[ip].line, tokens[ip].col,
+                      "变量 \'" + varName + "\' 未声明");
+            }
+            std::string op = tokens[ip+1].lexeme;
+            op = op.substr(0, 1);
+            double rightVal = 0;
+            if (tokens[ip+2].type == TokenType::NUMBER) {
+                rightVal = stringToDouble(tokens[ip+2].lexeme);
+            } else {
+                if (!hasVar(tokens[ip+2].lexeme)) {
+                    error(filename, tokens[ip+2].line, tokens[ip+2].col,
+                          "变量 \'" + tokens[ip+2].lexeme + "\' 未声明");
+                }
+                rightVal = getNumericVar(tokens[ip+2].lexeme);
+            }
+            double currentVal = getNumericVar(varName);
+            double result = performArithmeticOp(currentVal, op, rightVal);
+            VarType type = getVarType(varName);
+            setVar(varName, type, doubleToString(result));
+            ip += 4;
+            return true;
+        }
+
+        
+        if (tokens[ip].type == TokenType::IDENTIFIER && ip + 2 < tokens.size() &&
+            (tokens[ip+1].type == TokenType::PLUS_PLUS ||
+             tokens[ip+1].type == TokenType::MINUS_MINUS) &&
+            tokens[ip+2].type == TokenType::SEMICOLON) {
+            std::string varName = tokens[ip].lexeme;
+            if (!hasVar(varName)) {
+                error(filename, tokens[ip].line, tokens[ip].col,
+                      "变量 \'" + varName + "\' 未声明");
+            }
+            double currentVal = getNumericVar(varName);
+            double result = currentVal;
+            if (tokens[ip+1].type == TokenType::PLUS_PLUS) {
+                result = currentVal + 1;
+            } else {
+                result = currentVal - 1;
+            }
+            VarType type = getVarType(varName);
+            setVar(varName, type, doubleToString(result));
+            ip += 3;
+            return true;
+        }
+        return false;
+    }
+
+    
+    std::vector<std::string> parseFunctionArguments(const std::vector<Token>& tokens, size_t& ip) {
+        std::vector<std::string> args;
+
+        if (tokens[ip].type != TokenType::LPAREN) {
+            error(filename, tokens[ip].line, tokens[ip].col, "函数调用缺少 \'(\'");
+        }
+        ip++;
+
+        if (tokens[ip].type == TokenType::RPAREN) {
+            ip++;
+            return args;
+        }
+
+        while (ip < tokens.size()) {
+            if (tokens[ip].type == TokenType::NUMBER) {
+                args.push_back(tokens[ip].lexeme);
+                ip++;
+            } else if (tokens[ip].type == TokenType::STRING) {
+                args.push_back(tokens[ip].lexeme);
+                ip++;
+            } else if (tokens[ip].type == TokenType::IDENTIFIER) {
+                if (!hasVar(tokens[ip].lexeme)) {
+                    error(filename, tokens[ip].line, tokens[ip].col,
+                          "函数参数变量 \'" + tokens[ip].lexeme + "\' 未声明");
+                }
+                args.push_back(getVar(tokens[ip].lexeme));
+                ip++;
+            } else {
+                error(filename, tokens[ip].line, tokens[ip].col, "函数参数必须是数字、字符串或变量");
+            }
+
+            if (tokens[ip].type == TokenType::COMMA) {
+                ip++;
+            } else if (tokens[ip].type == TokenType::RPAREN) {
+                ip++;
+                break;
+            } else {
+                error(filename, tokens[ip].line, tokens[ip].col, "函数参数列表缺少 \',\' 或 \')\'");
+            }
+        }
+
+        return args;
+    }
+
+    
+    void callFunction(const std::string& funcName, const std::vector<std::string>& args, size_t& ip,
+                      const std::vector<std::string>& refs = {}) {
+        auto it = functions.find(funcName);
+        if (it == functions.end()) {
+            error(filename, 0, 0, "未定义的函数 \'" + funcName + "\'");
+        }
+
+        Function& func = it->second;
+
+        std::map<std::string, Variable> bound;
+        for (size_t i = 0; i < refs.size(); ++i) {
+            if (!refs[i].empty()) bound["arg" + std::to_string(i)] = vars[refs[i]];
+        }
+        callStack.push(std::move(vars));
+        vars = std::move(bound);
+
+        std::string allArgs;
+        for (size_t i = 0; i < args.size(); ++i) {
+            if (i > 0) allArgs += ",";
+            allArgs += args[i];
+        }
+
+        if (!allArgs.empty()) {
+            vars["_args"] = Variable(VarType::STRING, allArgs);
+        }
+
+        execute(func.body);
+
+        std::map<std::string, Variable> callee = std::move(vars);
+        vars = std::move(callStack.top());
+        callStack.pop();
+        for (size_t i = 0; i < refs.size(); ++i) {
+            if (refs[i].empty()) continue;
+            auto ref = callee.find("arg" + std::to_string(i));
+            if (ref != callee.end()) vars[refs[i]] = ref->second;
+        }
+    }
+
+    
+    void execute(const std::vector<Token>& tokens) {
+        size_t ip = 0;
+        while (ip < tokens.size()) {
+            const Token& t = tokens[ip];
+
+            if (t.type == TokenType::DTIME_TIC) {
+                timer.startTime = std::chrono::high_resolution_clock::now();
+                timer.isRunning = true;
+                hasTocExecuted = false;
+                ip++;
+                continue;
+            }
+
+            if (t.type == TokenType::DTIME_TOC) {
+                if (!timer.isRunning) {
+                    error(filename, t.line, t.col, "dtime_toc 必须在 dtime_tic 之后使用");
+                }
+
+                auto endTime = std::chrono::high_resolution_clock::now();
+                auto duration = std::chrono::duration_cast<std::chrono::microseconds>(endTime - timer.startTime);
+                lastTocTime = duration.count() / 1000.0;
+                timer.isRunning = false;
+                hasTocExecuted = true;
+
+                ip++;
+
+                if (ip < tokens.size() && tokens[ip].type == TokenType::LPAREN) {
+                    ip++;
+
+                    if (ip < tokens.size() && tokens[ip].type == TokenType::IDENTIFIER) {
+                        std::string varName = tokens[ip].lexeme;
+                        ip++;
+
+                        if (ip < tokens.size() && tokens[ip].type == TokenType::RPAREN) {
+                            ip++;
+
+                            if (ip < tokens.size() && tokens[ip].type == TokenType::SEMICOLON) {
+                                ip++;
+                                setVar(varName, VarType::DOUBLE, doubleToString(lastTocTime));
+                                continue;
+                            }
+                        }
+                    }
+
+                    ip = ip - 1;
+                }
+
+                if (ip < tokens.size() && tokens[ip].type == TokenType::LPAREN) {
+                    ip++;
+                    if (ip < tokens.size() && tokens[ip].type == TokenType::RPAREN) {
+                        ip++;
+                        if (ip < tokens.size() && tokens[ip].type == TokenType::SEMICOLON) {
+                            ip++;
+                        }
+                    }
+                }
+                continue;
+            }
+
+            
+            if (t.type == TokenType::RANDOM) {
+                size_t startIp = ip;
+                ip++;  
+
+                double minVal = -1e9;
+                double maxVal = 1e9;
+                bool isIntRange = false;
+
+                if (ip < tokens.size() && tokens[ip].type == TokenType::DOT) {
+                    ip++;
+                    isIntRange = true;
+
+                    if (ip < tokens.size() && tokens[ip].type == TokenType::NUMBER) {
+                        minVal = stringToDouble(tokens[ip].lexeme);
+                        ip++;
+                    } else {
+                        error(filename, t.line, t.col, "random 范围语法错误: 缺少最小值");
+                    }
+
+                    if (ip < tokens.size() && tokens[ip].type == TokenType::TILDE) {
+                        ip++;
+                    } else {
+                        error(filename, t.line, t.col, "random 范围语法错误: 缺少 ~");
+                    }
+
+                    if (ip < tokens.size() && tokens[ip].type == TokenType::NUMBER) {
+                        maxVal = stringToDouble(tokens[ip].lexeme);
+                        ip++;
+                    } else {
+                        error(filename, t.line, t.col, "random 范围语法错误: 缺少最大值");
+                    }
+
+                    if (minVal > maxVal) {
+                        error(filename, t.line, t.col, "random 范围错误: 最小值不能大于最大值");
+                    }
+                }
+
+                if (ip < tokens.size() && tokens[ip].type == TokenType::LPAREN) {
+                    ip++;
+                } else {
+                    error(filename, t.line, t.col, "random 语法错误: 缺少 \'(\'");
+                }
+
+                std::string varName;
+                if (ip < tokens.size() && tokens[ip].type == TokenType::IDENTIFIER) {
+                    varName = tokens[ip].lexeme;
+                    ip++;
+                } else {
+                    error(filename, t.line, t.col, "random 语法错误: 括号内必须指定变量名");
+                }
+
+                if (ip < tokens.size() && tokens[ip].type == TokenType::RPAREN) {
+                    ip++;
+                } else {
+                    error(filename, t.line, t.col, "random 语法错误: 缺少 \')\'");
+                }
+
+                if (ip < tokens.size() && tokens[ip].type == TokenType::SEMICOLON) {
+                    ip++;
+                } else {
+                    error(filename, t.line, t.col, "random 语句必须加分号");
+                }
+
+                
+                if (!hasVar(varName)) {
+                    error(filename, tokens[ip-4].line, tokens[ip-4].col,  
+                          "变量 \'" + varName + "\' 未声明，random 目标必须已声明");
+                }
+
+                double randomValue;
+                if (isIntRange) {
+                    int imin = static_cast<int>(minVal);
+                    int imax = static_cast<int>(maxVal);
+                    std::uniform_int_distribution<int> dist(imin, imax);
+                    randomValue = dist(rng);
+                } else {
+                    std::uniform_real_distribution<double> dist(minVal, maxVal);
+                    randomValue = dist(rng);
+                }
+
+                VarType type = getVarType(varName);
+                setVar(varName, type, doubleToString(randomValue));
+
+                continue;
+            }
+
+            
+            if (t.type == TokenType::CREATE && ip + 5 < tokens.size() &&
+                tokens[ip+1].type == TokenType::IDENTIFIER &&
+                tokens[ip+2].type == TokenType::LPAREN &&
+                tokens[ip+3].type == TokenType::FUNCTION &&
+                tokens[ip+4].type == TokenType::RPAREN &&
+                (tokens[ip+5].type == TokenType::FALID || 
+                 tokens[ip+5].type == TokenType::VALID)) {
+
+                std::string funcName = tokens[ip+1].lexeme;
+                bool hasReturn = (tokens[ip+5].type == TokenType::VALID);
+
+                size_t bodyStart = ip + 6;
+                if (bodyStart >= tokens.size() || tokens[bodyStart].type != TokenType::LBRACE) {
+                    error(filename, t.line, t.col, "函数定义缺少 \'{\'");
+                }
+
+                size_t depth = 1;
+                size_t bodyEnd = bodyStart + 1;
+                while (bodyEnd < tokens.size() && depth > 0) {
+                    if (tokens[bodyEnd].type == TokenType::LBRACE) depth++;
+                    else if (tokens[bodyEnd].type == TokenType::RBRACE) depth--;
+                    bodyEnd++;
+                }
+                if (depth != 0) {
+                    error(filename, t.line, t.col, "函数定义缺少闭合的 \'}\'");
+                }
+
+                std::vector<Token> body(tokens.begin() + bodyStart + 1, 
+                                       tokens.begin() + bodyEnd - 1);
+
+                functions[funcName] = Function(funcName, body, hasReturn);
+
+                ip = bodyEnd;
+                continue;
+            }
+
+            
+            if (isBuiltinCall(tokens, ip) && functions.find(t.lexeme) == functions.end()) {
+                callBuiltin(tokens, ip);
+                if (ip >= tokens.size() || tokens[ip].type != TokenType::SEMICOLON) {
+                    error(filename, t.line, t.col, "函数调用语句缺少分号");
+                }
+                ip++;
+                continue;
+            }
+
+            
+            if (t.type == TokenType::IDENTIFIER && ip + 1 < tokens.size() &&
+                tokens[ip+1].type == TokenType::LPAREN) {
+
+                std::string funcName = t.lexeme;
+                size_t startIp = ip;
+
+                ip += 2;
+
+                std::vector<std::string> args;
+                std::vector<std::string> refs;
+
+                int parenDepth = 1;
+                size_t paramStart = ip;
+
+                while (ip < tokens.size() && parenDepth > 0) {
+                    if (tokens[ip].type == TokenType::LPAREN) parenDepth++;
+                    else if (tokens[ip].type == TokenType::RPAREN) parenDepth--;
+                    ip++;
+                }
+
+                if (parenDepth != 0) {
+                    ip = startIp;
+                } else {
+                    size_t paramEnd = ip - 1;
+
+                    for (size_t paramIdx = paramStart; paramIdx < paramEnd; ++paramIdx) {
+                        if (tokens[paramIdx].type == TokenType::IDENTIFIER) {
+                            if (!hasVar(tokens[paramIdx].lexeme)) {
+                                error(filename, tokens[paramIdx].line, tokens[paramIdx].col,
+                                      "函数参数变量 \'" + tokens[paramIdx].lexeme + "\' 未声明");
+                            }
+                            const Variable& arg = vars[tokens[paramIdx].lexeme];
+                            refs.push_back(arg.isContainer() ? tokens[paramIdx].lexeme : "");
+                            args.push_back(getVar(tokens[paramIdx].lexeme));
+                        } else if (tokens[paramIdx].type == TokenType::NUMBER ||
+                                   tokens[paramIdx].type == TokenType::STRING) {
+                            refs.push_back("");
+                            args.push_back(tokens[paramIdx].lexeme);
+                        }
+                    }
+                }
+
+                if (ip < tokens.size() && tokens[ip].type == TokenType::SEMICOLON) {
+                    callFunction(funcName, args, ip, refs);
+                    ip++;
+                    continue;
+                } else {
+                    ip = startIp;
+                }
+            }
+
+            
+            if (t.type == TokenType::OUTPUT_REDIRECT) {
+                ip = runOutputStatement(tokens, ip);
+                continue;
+            }
+
+            
+            if (t.type == TokenType::OUTLB && ip + 1 < tokens.size() &&
+                tokens[ip+1].type == TokenType::SEMICOLON) {
+                output().endLine();
+                ip += 2;
+                continue;
+            }
+
+            
+            if (t.type == TokenType::INPUT_REDIRECT && ip + 2 < tokens.size() &&
+                tokens[ip+1].type == TokenType::IDENTIFIER &&
+                tokens[ip+2].type == TokenType::SEMICOLON) {
+                std::string varName = tokens[ip+1].lexeme;
+                if (!hasVar(varName)) {
+                    error(filename, tokens[ip+1].line, tokens[ip+1].col,
+                          "变量 \'" + varName + "\' 未声明，不能接收输入");
+                }
+                if (isArrayVar(varName)) {
+                    readArrayInput(varName, tokens[ip+1]);
+                    ip += 3;
+                    continue;
+                }
+                std::string line;
+                input().readLine(line);
+                VarType type = getVarType(varName);
+                setVar(varName, type, line);
+                ip += 3;
+                continue;
+            }
+
+            
+            if (parseAssignment(tokens, ip)) {
+                continue;
+            }
+
+            
+            if (t.type == TokenType::IF && ip + 5 < tokens.size() &&
+                tokens[ip+1].type == TokenType::LPAREN &&
+                tokens[ip+2].type == TokenType::IDENTIFIER &&
+                (tokens[ip+3].type == TokenType::GT || tokens[ip+3].type == TokenType::LT ||
+                 tokens[ip+3].type == TokenType::GTE || tokens[ip+3].type == TokenType::LTE ||
+                 tokens[ip+3].type == TokenType::EQ || tokens[ip+3].type == TokenType::NEQ) &&
+                (tokens[ip+4].type == TokenType::NUMBER || tokens[ip+4].type == TokenType::IDENTIFIER) &&
+                tokens[ip+5].type == TokenType::RPAREN) {
+
+                std::string varName = tokens[ip+2].lexeme;
+                std::string op = tokens[ip+3].lexeme;
+                std::string limitStr = tokens[ip+4].lexeme;
+                int limit = 0;
+                if (tokens[ip+4].type == TokenType::NUMBER) {
+                    limit = stringToDouble(limitStr);
+                } else {
+                    if (!hasVar(limitStr)) {
+                        error(filename, tokens[ip+4].line, tokens[ip+4].col,
+                              "变量 \'" + limitStr + "\' 未声明");
+                    }
+                    limit = getNumericVar(limitStr);
+                }
+                if (!hasVar(varName)) {
+                    error(filename, tokens[ip+2].line, tokens[ip+2].col,
+                          "变量 \'" + varName + "\' 未声明");
+                }
+                double cur = getNumericVar(varName);
+                bool cond = false;
+                if (op == ">") cond = (cur > limit);
+                else if (op == "<") cond = (cur < limit);
+                else if (op == ">=") cond = (cur >= limit);
+                else if (op == "<=") cond = (cur <= limit);
+                else if (op == "==") cond = (cur == limit);
+                else if (op == "!=") cond = (cur != limit);
+
+                size_t braceStart = ip + 6;
+                if (braceStart >= tokens.size() || tokens[braceStart].type != TokenType::LBRACE) {
+                    error(filename, t.line, t.col, "if 语句缺少 {");
+                }
+                size_t braceEnd = braceStart + 1;
+                int depth = 1;
+                while (braceEnd < tokens.size() && depth > 0) {
+                    if (tokens[braceEnd].type == TokenType::LBRACE) depth++;
+                    else if (tokens[braceEnd].type == TokenType::RBRACE) depth--;
+                    braceEnd++;
+                }
+                if (depth != 0) error(filename, t.line, t.col, "if 语句缺少闭合的 }");
+
+                if (cond) {
+                    std::vector<Token> body(tokens.begin() + braceStart + 1, tokens.begin() + braceEnd - 1);
+                    Interpreter sub(filename);
+                    sub.recordTypes = recordTypes;
+                    sub.vars = std::move(vars);
+                    sub.execute(body);
+                    vars = std::move(sub.vars);
+                }
+                ip = braceEnd;
+                continue;
+            }
+
+            
+            if (t.type == TokenType::WHILE && ip + 5 < tokens.size() &&
+                tokens[ip+1].type == TokenType::LPAREN &&
+                tokens[ip+2].type == TokenType::IDENTIFIER &&
+                (tokens[ip+3].type == TokenType::LT || tokens[ip+3].type == TokenType::LTE ||
+                 tokens[ip+3].type == TokenType::GT || tokens[ip+3].type == TokenType::GTE ||
+                 tokens[ip+3].type == TokenType::EQ || tokens[ip+3].type == TokenType::NEQ) &&
+                (tokens[ip+4].type == TokenType::NUMBER || tokens[ip+4].type == TokenType::IDENTIFIER) &&
+                tokens[ip+5].type == TokenType::RPAREN) {
+
+                std::string varName = tokens[ip+2].lexeme;
+                std::string op = tokens[ip+3].lexeme;
+                std::string limitStr = tokens[ip+4].lexeme;
+                int limit = 0;
+                if (tokens[ip+4].type == TokenType::NUMBER) {
+                    limit = stringToDouble(limitStr);
+                } else {
+                    if (!hasVar(limitStr)) {
+                        error(filename, tokens[ip+4].line, tokens[ip+4].col,
+                              "变量 \'" + limitStr + "\' 未声明");
+                    }
+                    limit = getNumericVar(limitStr);
+                }
+                if (!hasVar(varName)) {
+                    error(filename, tokens[ip+2].line, tokens[ip+2].col,
+                          "变量 \'" + varName + "\' 未声明");
+                }
+
+                size_t braceStart = ip + 6;
+                if (braceStart >= tokens.size() || tokens[braceStart].type != TokenType::LBRACE) {
+                    error(filename, t.line, t.col, "while 循环缺少 {");
+                }
+                size_t braceEnd = braceStart + 1;
+                int depth = 1;
+                while (braceEnd < tokens.size() && depth > 0) {
+                    if (tokens[braceEnd].type == TokenType::LBRACE) depth++;
+                    else if (tokens[braceEnd].type == TokenType::RBRACE) depth--;
+                    braceEnd++;
+                }
+                if (depth != 0) error(filename, t.line, t.col, "while 循环缺少闭合的 }");
+
+                std::vector<Token> body(tokens.begin() + braceStart + 1, tokens.begin() + braceEnd - 1);
+                while (true) {
+                    double cur = getNumericVar(varName);
+                    bool cond = false;
+                    if (op == "<") cond = (cur < limit);
+                    else if (op == "<=") cond = (cur <= limit);
+                    else if (op == ">") cond = (cur > limit);
+                    else if (op == ">=") cond = (cur >= limit);
+                    else if (op == "==") cond = (cur == limit);
+                    else if (op == "!=") cond = (cur != limit);
+                    if (!cond) break;
+
+                    Interpreter sub(filename);
+                    sub.recordTypes = recordTypes;
+                    sub.vars = std::move(vars);
+                    sub.execute(body);
+                    vars = std::move(sub.vars);
+                }
+                ip = braceEnd;
+                continue;
+            }
+
+            
+            if (t.type == TokenType::LOOP && ip + 3 < tokens.size() &&
+                tokens[ip+1].type == TokenType::LPAREN) {
+
+                int count = 0;
+                if (tokens[ip+2].type == TokenType::NUMBER) {
+                    count = stringToDouble(tokens[ip+2].lexeme);
+                } else if (tokens[ip+2].type == TokenType::IDENTIFIER) {
+                    if (!hasVar(tokens[ip+2].lexeme)) {
+                        error(filename, tokens[ip+2].line, tokens[ip+2].col,
+                              "变量 \'" + tokens[ip+2].lexeme + "\' 未声明");
+                    }
+                    count = getNumericVar(tokens[ip+2].lexeme);
+                } else {
+                    error(filename, t.line, t.col, "loop 循环次数必须是数字或标识符");
+                }
+                if (tokens[ip+3].type != TokenType::RPAREN) {
+                    error(filename, t.line, t.col, "loop 语句括号不匹配");
+                }
+
+                size_t braceStart = ip + 4;
+                if (braceStart >= tokens.size() || tokens[braceStart].type != TokenType::LBRACE) {
+                    error(filename, t.line, t.col, "loop 语句缺少 {");
+                }
+                size_t braceEnd = braceStart + 1;
+                int depth = 1;
+                while (braceEnd < tokens.size() && depth > 0) {
+                    if (tokens[braceEnd].type == TokenType::LBRACE) depth++;
+                    else if (tokens[braceEnd].type == TokenType::RBRACE) depth--;
+                    braceEnd++;
+                }
+                if (depth != 0) error(filename, t.line, t.col, "loop 语句缺少闭合的 }");
+
+                std::vector<Token> body(tokens.begin() + braceStart + 1, tokens.begin() + braceEnd - 1);
+                for (int i = 0; i < count; i++) {
+                    Interpreter sub(filename);
+                    sub.recordTypes = recordTypes;
+                    sub.vars = std::move(vars);
+                    sub.execute(body);
+                    vars = std::move(sub.vars);
+                }
+                ip = braceEnd;
+                continue;
+            }
+
+            
+            if (t.type == TokenType::FOR && ip + 13 < tokens.size() &&
+                tokens[ip+1].type == TokenType::LPAREN &&
+                tokens[ip+2].type == TokenType::CREATE_INT &&
+                tokens[ip+3].type == TokenType::IDENTIFIER &&
+                tokens[ip+4].type == TokenType::ASSIGN &&
+                (tokens[ip+5].type == TokenType::NUMBER || tokens[ip+5].type == TokenType::IDENTIFIER) &&
+                tokens[ip+6].type == TokenType::SEMICOLON &&
+                tokens[ip+7].type == TokenType::IDENTIFIER &&
+                (tokens[ip+8].type == TokenType::LT || tokens[ip+8].type == TokenType::LTE ||
+                 tokens[ip+8].type == TokenType::GT || tokens[ip+8].type == TokenType::GTE ||
+                 tokens[ip+8].type == TokenType::EQ) &&
+                (tokens[ip+9].type == TokenType::NUMBER || tokens[ip+9].type == TokenType::IDENTIFIER) &&
+                tokens[ip+10].type == TokenType::SEMICOLON &&
+                tokens[ip+11].type == TokenType::IDENTIFIER &&
+                tokens[ip+12].type == TokenType::PLUS_PLUS &&
+                tokens[ip+13].type == TokenType::RPAREN) {
+
+                std::string initVar = tokens[ip+3].lexeme;
+                std::string initValStr = tokens[ip+5].lexeme;
+                int initVal = 0;
+                if (tokens[ip+5].type == TokenType::NUMBER) {
+                    initVal = stringToDouble(initValStr);
+                } else {
+                    if (!hasVar(initValStr)) {
+                        error(filename, tokens[ip+5].line, tokens[ip+5].col,
+                              "变量 \'" + initValStr + "\' 未声明");
+                    }
+                    initVal = getNumericVar(initValStr);
+                }
+                std::string condVar = tokens[ip+7].lexeme;
+                std::string op = tokens[ip+8].lexeme;
+                std::string limitStr = tokens[ip+9].lexeme;
+                int limit = 0;
+                if (tokens[ip+9].type == TokenType::NUMBER) {
+                    limit = stringToDouble(limitStr);
+                } else {
+                    if (!hasVar(limitStr)) {
+                        error(filename, tokens[ip+9].line, tokens[ip+9].col,
+                              "变量 \'" + limitStr + "\' 未声明");
+                    }
+                    limit = getNumericVar(limitStr);
+                }
+                std::string updateVar = tokens[ip+11].lexeme;
+
+                size_t braceStart = ip + 14;
+                if (braceStart >= tokens.size() || tokens[braceStart].type != TokenType::LBRACE) {
+                    error(filename, t.line, t.col, "for 循环缺少 {");
+                }
+                size_t braceEnd = braceStart + 1;
+                int depth = 1;
+                while (braceEnd < tokens.size() && depth > 0) {
+                    if (tokens[braceEnd].type == TokenType::LBRACE) depth++;
+                    else if (tokens[braceEnd].type == TokenType::RBRACE) depth--;
+                    braceEnd++;
+                }
+                if (depth != 0) error(filename, t.line, t.col, "for 循环缺少闭合的 }");
+
+                std::vector<Token> body(tokens.begin() + braceStart + 1, tokens.begin() + braceEnd - 1);
+                setVar(initVar, VarType::INT, std::to_string(initVal));
+                while (true) {
+                    if (!hasVar(condVar)) {
+                        error(filename, tokens[ip+7].line, tokens[ip+7].col,
+                              "变量 \'" + condVar + "\' 未声明");
+                    }
+                    double cur = getNumericVar(condVar);
+                    bool cond = false;
+                    if (op == "<") cond = (cur < limit);
+                    else if (op == "<=") cond = (cur <= limit);
+                    else if (op == ">") cond = (cur > limit);
+                    else if (op == ">=") cond = (cur >= limit);
+                    else if (op == "==") cond = (cur == limit);
+                    if (!cond) break;
+
+                    Interpreter sub(filename);
+                    sub.recordTypes = recordTypes;
+                    sub.vars = std::move(vars);
+                    sub.execute(body);
+                    vars = std::move(sub.vars);
+
+                    if (!hasVar(updateVar)) {
+                        error(filename, tokens[ip+11].line, tokens[ip+11].col,
+                              "变量 \'" + updateVar + "\' 未声明");
+                    }
+                    double current_dbl = getNumericVar(updateVar);
+                    setVar(updateVar, VarType::INT, std::to_string(static_cast<int>(current_dbl) + 1));
+                }
+                ip = braceEnd;
+                continue;
+            }
+
+            
+            if (t.type == TokenType::FINISH && ip + 4 < tokens.size() &&
+                tokens[ip+1].type == TokenType::LPAREN &&
+                tokens[ip+2].type == TokenType::IDENTIFIER &&
+                tokens[ip+3].type == TokenType::RPAREN &&
+                tokens[ip+4].type == TokenType::SEMICOLON) {
+
+                std::string funcName = tokens[ip+2].lexeme;
+                if (funcName != "main") {
+                    error(filename, tokens[ip+2].line, tokens[ip+2].col,
+                          "finish 语句必须写为 finish(main); 其他名称不被允许");
+                }
+                output().flush();
+                exit(0);
+            }
+
+            
+            if (t.type == TokenType::ACCEPT && ip + 4 < tokens.size() &&
+                tokens[ip+1].type == TokenType::IDENTIFIER &&
+                tokens[ip+2].lexeme == "function" &&
+                tokens[ip+3].type == TokenType::DOT &&
+                tokens[ip+4].type == TokenType::IDENTIFIER &&
+                tokens[ip+4].lexeme == "main") {
+
+                size_t acceptStart = ip + 5;
+                while (acceptStart < tokens.size() && tokens[acceptStart].type != TokenType::PIPE) {
+                    acceptStart++;
+                }
+
+                if (acceptStart < tokens.size() && tokens[acceptStart].type == TokenType::PIPE) {
+                    acceptStart++;
+                    if (acceptStart + 1 < tokens.size() &&
+                        tokens[acceptStart].type == TokenType::IDENTIFIER &&
+                        tokens[acceptStart].lexeme == "set" &&
+                        tokens[acceptStart+1].type == TokenType::IDENTIFIER &&
+                        (acceptStart + 2 >= tokens.size() || tokens[acceptStart+2].type == TokenType::SEMICOLON)) {
+
+                        std::string varName = tokens[acceptStart+1].lexeme;
+
+                        
+                        if (!hasVar(varName)) {
+                            error(filename, tokens[acceptStart+1].line, tokens[acceptStart+1].col,
+                                  "变量 \'" + varName + "\' 未声明，accept 目标必须已声明");
+                        }
+
+                        auto it = vars.find("_args");
+                        if (it != vars.end()) {
+                            vars[varName] = it->second;
+                        } else {
+                            setVar(varName, VarType::OMNI, "");
+                        }
+
+                        ip = acceptStart + 2;
+                        if (ip < tokens.size() && tokens[ip].type == TokenType::SEMICOLON) {
+                            ip++;
+                        }
+                        continue;
+                    }
+                }
+
+                error(filename, t.line, t.col, "accept>function.main 语法错误");
+            }
+
+            ip++;
+        }
+    }
+
+    
+    void streamRecords(const std::vector<Token>& each, const std::vector<Token>* teardown) {
+        vars["line"] = Variable(VarType::OMNI, "");
+        vars["nr"] = Variable(VarType::INT, "0");
+        InputReader& reader = input();
+        const char* p = nullptr;
+        size_t n = 0;
+        double count = 0;
+        char digits[NUMBER_CHARS];
+        while (reader.nextLine(p, n)) {
+            auto line = vars.find("line");
+            if (line == vars.end() || line->second.isContainer()) {
+                line = vars.insert_or_assign("line", Variable(VarType::OMNI, "")).first;
+            }
+            line->second.value.assign(p, n);
+            Variable& nr = vars["nr"];
+            nr.value.assign(digits, formatNumberTo(digits, digits + sizeof(digits), ++count));
+            execute(each);
+        }
+        if (teardown) execute(*teardown);
+    }
+
+    
+    void readArrayInput(const std::string& name, const Token& at) {
+        NumBuffer nums;
+        std::string bad;
+        if (!input().readNumbers(nums, bad)) {
+            error(filename, at.line, at.col, "输入中的 \'" + bad + "\' 不是数字，无法读入数组 \'" + name + "\'");
+        }
+        Variable arr(VarType::ARRAY, "");
+        arr.setDims({nums.size()});
+        arr.store->nums.swap(nums);
+        vars[name] = std::move(arr);
+    }
+
+    
+    const OutputTemplate& outputTemplate(const std::vector<Token>& tokens, size_t start) {
+        std::shared_ptr<const OutputTemplate>& slot = *tokens[start].outputTemplate;
+        if (!slot) slot = compileOutputStatement(tokens, start);
+        return *slot;
+    }
+
+    
+    std::shared_ptr<const OutputTemplate> compileOutputStatement(const std::vector<Token>& tokens, size_t start) {
+        auto tpl = std::make_shared<OutputTemplate>();
+        size_t end = start + 1;
+        while (end < tokens.size() && tokens[end].type != TokenType::SEMICOLON) end++;
+        if (end >= tokens.size()) {
+            error(filename, tokens[start].line, tokens[start].col, "输出语句缺少分号");
+        }
+        tpl->length = end - start;
+
+        size_t i = start + 1;
+        while (i < end) {
+            if (tokens[i].type == TokenType::OUTLB) {
+                tpl->newline = true;
+                i++;
+                continue;
+            }
+            if (tokens[i].type == TokenType::OUTPUT_CONNECT) {
+                i++;
+                continue;
+            }
+            size_t segmentEnd = i;
+            while (segmentEnd < end &&
+                   tokens[segmentEnd].type != TokenType::OUTLB &&
+                   tokens[segmentEnd].type != TokenType::OUTPUT_CONNECT) {
+                segmentEnd++;
+            }
+            OutputPiece spec;
+            size_t valueEnd = parseOutputSpec(tokens, i, segmentEnd, spec);
+            size_t first = tpl->pieces.size();
+            compileOutputSegment(tokens, start, i, valueEnd, tpl->pieces);
+            if (spec.formatted) {
+                if (tpl->pieces.size() != first + 1) {
+                    error(filename, tokens[valueEnd].line, tokens[valueEnd].col, "格式说明只能修饰单个输出值");
+                }
+                OutputPiece& piece = tpl->pieces.back();
+                piece.formatted = true;
+                piece.leftAlign = spec.leftAlign;
+                piece.width = spec.width;
+                piece.precision = spec.precision;
+            }
+            i = segmentEnd;
+        }
+
+        std::vector<OutputPiece> merged;
+        for (OutputPiece& piece : tpl->pieces) {
+            bool literal = piece.kind == OutputPiece::Kind::LITERAL && !piece.formatted;
+            if (literal && !merged.empty() && merged.back().kind == OutputPiece::Kind::LITERAL &&
+                !merged.back().formatted) {
+                merged.back().text += piece.text;
+            } else {
+                merged.push_back(std::move(piece));
+            }
+        }
+        tpl->pieces = std::move(merged);
+        return tpl;
+    }
+
+    
+    size_t parseOutputSpec(const std::vector<Token>& tokens, size_t b, size_t e, OutputPiece& spec) {
+        size_t colon = e;
+        int depth = 0;
+        for (size_t k = b; k < e; ++k) {
+            TokenType type = tokens[k].type;
+            if (type == TokenType::QUESTION) return e;
+            if (type == TokenType::LPAREN || type == TokenType::LBRACKET || type == TokenType::LBRACE) depth++;
+            else if (type == TokenType::RPAREN || type == TokenType::RBRACKET || type == TokenType::RBRACE) depth--;
+            else if (type == TokenType::COLON && depth == 0 && k > b) colon = k;
+        }
+        if (colon == e) return e;
+
+        std::string text;
+        for (size_t k = colon + 1; k < e; ++k) {
+            TokenType type = tokens[k].type;
+            if (type != TokenType::NUMBER && type != TokenType::MINUS && type != TokenType::DOT) return e;
+            text += tokens[k].lexeme;
+        }
+        const char* p = text.data();
+        const char* last = p + text.size();
+        if (p < last && *p == '-') {
+            spec.leftAlign = true;
+            p++;
+        }
+        if (p < last && isdigit(static_cast<unsigned char>(*p))) {
+            auto r = std::from_chars(p, last, spec.width);
+            if (r.ec != std::errc()) p = last + 1;
+            else p = r.ptr;
+        }
+        if (p < last && *p == '.') {
+            p++;
+            auto r = std::from_chars(p, last, spec.precision);
+            if (r.ec != std::errc() || spec.precision > 100) p = last + 1;
+            else p = r.ptr;
+        }
+        if (text.empty() || p != last || text == "-") {
+            error(filename, tokens[colon].line, tokens[colon].col,
+                  "输出格式说明无效，应写为 :宽度、:宽度.精度 或 :.精度，负宽度表示左对齐");
+        }
+        spec.formatted = true;
+        return colon;
+    }
+
+    
+    void compileOutputSegment(const std::vector<Token>& tokens, size_t start, size_t b, size_t e,
+                              std::vector<OutputPiece>& pieces) {
+        size_t i = b;
+        while (i < e) {
+            const Token& tok = tokens[i];
+            if (tok.type == TokenType::STRING || tok.type == TokenType::NUMBER) {
+                OutputPiece piece(OutputPiece::Kind::LITERAL);
+                piece.text = tok.lexeme;
+                pieces.push_back(std::move(piece));
+                i++;
+            } else if (tok.type == TokenType::DTIME_FUNC) {
+                OutputPiece piece(OutputPiece::Kind::DTIME);
+                piece.begin = i - start;
+                pieces.push_back(std::move(piece));
+                i++;
+            } else if (tok.type == TokenType::IDENTIFIER && i + 1 < e &&
+                       (tokens[i+1].type == TokenType::LBRACKET || tokens[i+1].type == TokenType::DOT ||
+                        isBuiltinCall(tokens, i))) {
+                OutputPiece piece(OutputPiece::Kind::VALUE);
+                piece.begin = i - start;
+                piece.end = e - start;
+                pieces.push_back(std::move(piece));
+                i = e;
+            } else if (tok.type == TokenType::IDENTIFIER) {
+                OutputPiece piece(OutputPiece::Kind::VARIABLE);
+                piece.text = tok.lexeme;
+                piece.begin = i - start;
+                pieces.push_back(std::move(piece));
+                i++;
+            } else {
+                OutputPiece piece(OutputPiece::Kind::EXPR);
+                piece.begin = i - start;
+                piece.expr.assign(tokens.begin() + i, tokens.begin() + e);
+                pieces.push_back(std::move(piece));
+                i = e;
+            }
+        }
+    }
+
+    
+    size_t runOutputStatement(const std::vector<Token>& tokens, size_t start) {
+        const OutputTemplate& tpl = outputTemplate(tokens, start);
+        OutputBuffer& out = output();
+        for (const OutputPiece& piece : tpl.pieces) {
+            if (!piece.formatted && piece.kind == OutputPiece::Kind::LITERAL) {
+                out.write(piece.text);
+            } else if (!piece.formatted && piece.kind == OutputPiece::Kind::VARIABLE) {
+                auto it = vars.find(piece.text);
+                if (it == vars.end()) {
+                    const Token& tok = tokens[start + piece.begin];
+                    error(filename, tok.line, tok.col, "变量 \'" + piece.text + "\' 未声明");
+                }
+                if (it->second.isContainer()) out.write(it->second.displayString());
+                else out.write(it->second.value);
+            } else {
+                writeOutputPiece(tokens, start, piece, out);
+            }
+        }
+        if (tpl.newline) {
+            out.endLine();
+        } else {
+            out.flushIfStale();
+        }
+        return start + tpl.length + 1;
+    }
+
+    
+    void writeOutputPiece(const std::vector<Token>& tokens, size_t start, const OutputPiece& piece, OutputBuffer& out) {
+        std::string text;
+        double number = 0;
+        bool isNumber = false;
+        const Token& tok = tokens[start + piece.begin];
+        switch (piece.kind) {
+        case OutputPiece::Kind::LITERAL:
+            text = piece.text;
+            break;
+        case OutputPiece::Kind::DTIME:
+            if (!hasTocExecuted) {
+                error(filename, tok.line, tok.col, "dtime() 必须在 dtime_toc 之后使用");
+            }
+            number = lastTocTime;
+            isNumber = true;
+            break;
+        case OutputPiece::Kind::VARIABLE:
+            if (!hasVar(piece.text)) {
+                error(filename, tok.line, tok.col, "变量 \'" + piece.text + "\' 未声明");
+            }
+            text = getVar(piece.text);
+            break;
+        case OutputPiece::Kind::VALUE:
+            text = evaluateValue(tokens, start + piece.begin, start + piece.end).displayString();
+            break;
+        case OutputPiece::Kind::EXPR: {
+            size_t idx = 0;
+            number = evaluateExpr(piece.expr, idx);
+            isNumber = true;
+            break;
+        }
+        }
+
+        if (!piece.formatted) {
+            if (isNumber) out.writeNumber(number);
+            else out.write(text);
+            return;
+        }
+        char buf[512];
+        const char* p = nullptr;
+        size_t n = 0;
+        if (piece.precision >= 0 && !isNumber) {
+            const char* last = text.data() + text.size();
+            auto r = std::from_chars(text.data(), last, number);
+            isNumber = !text.empty() && r.ec == std::errc() && r.ptr == last;
+        }
+        if (piece.precision >= 0 && isNumber) {
+            auto r = std::to_chars(buf, buf + sizeof(buf), number, std::chars_format::fixed, piece.precision);
+            if (r.ec == std::errc()) {
+                p = buf;
+                n = static_cast<size_t>(r.ptr - buf);
+            }
+        }
+        if (!p) {
+            if (isNumber && text.empty()) text = doubleToString(number);
+            p = text.data();
+            n = piece.precision >= 0 ? utf8Prefix(text.data(), text.size(), piece.precision) : text.size();
+        }
+        out.writePadded(p, n, piece.width, piece.leftAlign);
+    }
+
+    
+    Variable numberResult(double v) {
+        return Variable(VarType::DOUBLE, doubleToString(v));
+    }
+
+    
+    void requireElements(CallArgs& args, const Variable& arr) {
+        if (arr.elementCount() == 0) {
+            error(filename, args.callee.line, args.callee.col,
+                  "函数 \'" + args.callee.lexeme + "\' 不能用于空数组");
+        }
+    }
+
+    
+    const double* requireNonEmpty(CallArgs& args, const Variable& arr, std::vector<double>& scratch, size_t& n) {
+        requireElements(args, arr);
+        return arr.foldedData(scratch, n);
+    }
+
+    
+    template <bool IsMax>
+    size_t argExtreme(CallArgs& args, const Variable& arr) {
+        std::vector<double> scratch;
+        size_t n;
+        const double* p = requireNonEmpty(args, arr, scratch, n);
+        if (!arr.isSparse()) return reduceArgExtreme<IsMax>(p, n);
+        double target = reduceExtreme<IsMax>(p, n);
+        size_t best = SIZE_MAX;
+        for (const auto& cell : arr.store->cells) {
+            if (cell.second == target && cell.first < best) best = cell.first;
+        }
+        if (target == 0.0) {
+            size_t zero = 0;
+            while (zero < best && arr.store->cells.count(zero)) zero++;
+            if (zero < arr.elementCount()) best = std::min(best, zero);
+        }
+        return best == SIZE_MAX ? 0 : best;
+    }
+
+    
+    Variable builtinSum(CallArgs& args) {
+        expectArgs(args, 1, 2);
+        Variable arr = argArray(args, 0);
+        return numberResult(arr.sum(argSumMode(args, 1)));
+    }
+
+    
+    Variable builtinMean(CallArgs& args) {
+        expectArgs(args, 1, 2);
+        Variable arr = argArray(args, 0);
+        requireElements(args, arr);
+        return numberResult(arr.sum(argSumMode(args, 1)) / arr.elementCount());
+    }
+
+    
+    Variable builtinMin(CallArgs& args) {
+        expectArgs(args, 1, 1);
+        Variable arr = argArray(args, 0);
+        std::vector<double> scratch;
+        size_t n;
+        const double* p = requireNonEmpty(args, arr, scratch, n);
+        return numberResult(reduceExtreme<false>(p, n));
+    }
+
+    
+    Variable builtinMax(CallArgs& args) {
+        expectArgs(args, 1, 1);
+        Variable arr = argArray(args, 0);
+        std::vector<double> scratch;
+        size_t n;
+        const double* p = requireNonEmpty(args, arr, scratch, n);
+        return numberResult(reduceExtreme<true>(p, n));
+    }
+
+    
+    Variable builtinArgmin(CallArgs& args) {
+        expectArgs(args, 1, 1);
+        Variable arr = argArray(args, 0);
+        return numberResult(static_cast<double>(argExtreme<false>(args, arr)));
+    }
+
+    
+    Variable builtinArgmax(CallArgs& args) {
+        expectArgs(args, 1, 1);
+        Variable arr = argArray(args, 0);
+        return numberResult(static_cast<double>(argExtreme<true>(args, arr)));
+    }
+
+    
+    Variable builtinProd(CallArgs& args) {
+        expectArgs(args, 1, 1);
+        Variable arr = argArray(args, 0);
+        std::vector<double> scratch;
+        size_t n;
+        const double* p = arr.foldedData(scratch, n);
+        return numberResult(reduceProd(p, n));
+    }
+
+    
+    Variable builtinDot(CallArgs& args) {
+        expectArgs(args, 2, 2);
+        Variable a = argArray(args, 0);
+        Variable b = argArray(args, 1);
+        if (a.elementCount() != b.elementCount()) {
+            error(filename, args.callee.line, args.callee.col,
+                  "dot() 两个数组的元素数量不一致: " + std::to_string(a.elementCount()) +
+                  " 与 " + std::to_string(b.elementCount()));
+        }
+        if (b.isSparse() && (!a.isSparse() || b.store->cells.size() < a.store->cells.size())) std::swap(a, b);
+        std::vector<double> scratchA, scratchB;
+        if (a.isSparse()) {
+            double sum = 0.0;
+            if (b.isSparse()) {
+                for (const auto& cell : a.store->cells) sum += cell.second * b.store->sparseAt(cell.first);
+            } else {
+                const double* q = b.numericData(scratchB);
+                for (const auto& cell : a.store->cells) sum += cell.second * q[cell.first];
+            }
+            return numberResult(sum);
+        }
+        return numberResult(reduceDot(a.numericData(scratchA), b.numericData(scratchB), a.elementCount()));
+    }
+
+    
+    Variable builtinScan(CallArgs& args) {
+        expectArgs(args, 1, 1);
+        Variable arr = argArray(args, 0);
+        Variable out(VarType::ARRAY);
+        out.setDims(arr.dims);
+        std::vector<double> scratch;
+        prefixSum(arr.numericData(scratch), out.store->nums.data(), arr.elementCount());
+        return out;
+    }
+
+    
+    void sortWithArgs(CallArgs& args, Variable& arr) {
+        SortOptions opt;
+        bool hasAxis = false;
+        size_t axis = 0;
+        for (size_t i = 1; i < args.size(); ++i) {
+            const Token& t = args.tokens[args.ranges[i].first];
+            Variable v = argValue(args, i);
+            if (v.type == VarType::STRING) {
+                std::stringstream spec(v.value);
+                std::string word;
+                while (spec >> word) {
+                    if (word == "desc") opt.descending = true;
+                    else if (word == "asc") opt.descending = false;
+                    else if (word == "stable") opt.stable = true;
+                    else error(filename, t.line, t.col, "未知的排序选项 \'" + word + "\'，可选 asc、desc、stable");
+                }
+            } else {
+                double a = v.getNumericValue();
+                if (a < 0 || a != std::floor(a) || a >= arr.dims.size()) {
+                    error(filename, t.line, t.col, "排序轴必须是 0 到 " +
+                          std::to_string(arr.dims.size() - 1) + " 之间的整数");
+                }
+                hasAxis = true;
+                axis = static_cast<size_t>(a);
+            }
+        }
+        if (hasAxis) arr.sortAxis(axis, opt);
+        else arr.sort(opt);
+    }
+
+    
+    Variable builtinSort(CallArgs& args) {
+        expectArgs(args, 1, 3);
+        Variable arr = argArray(args, 0);
+        if (arr.records) {
+            const Token& t = args.tokens[args.ranges[0].first];
+            error(filename, t.line, t.col,
+                  "sort 不能原地排序记录数组的单个字段，否则各字段会错位；请使用 sorted(column(...))");
+        }
+        sortWithArgs(args, arr);
+        return arr;
+    }
+
+    
+    Variable builtinSorted(CallArgs& args) {
+        expectArgs(args, 1, 3);
+        Variable arr = argArray(args, 0).clone();
+        sortWithArgs(args, arr);
+        return arr;
+    }
+
+    
+    Variable argMatrix(CallArgs& args, size_t i) {
+        Variable v = argArray(args, i);
+        if (v.dims.size() != 2) {
+            const Token& t = args.tokens[args.ranges[i].first];
+            error(filename, t.line, t.col,
+                  "函数 \'" + args.callee.lexeme + "\' 的第 " + std::to_string(i + 1) + " 个参数必须是二维数组");
+        }
+        return v;
+    }
+
+    
+    Variable argVector(CallArgs& args, size_t i) {
+        Variable v = argArray(args, i);
+        expectVector(args, i, v);
+        return v;
+    }
+
+    
+    void expectVector(CallArgs& args, size_t i, const Variable& v) {
+        if (v.dims.size() != 1) {
+            const Token& t = args.tokens[args.ranges[i].first];
+            error(filename, t.line, t.col,
+                  "函数 \'" + args.callee.lexeme + "\' 的第 " + std::to_string(i + 1) + " 个参数必须是一维数组");
+        }
+    }
+
+    
+    Variable builtinMatmul(CallArgs& args) {
+        expectArgs(args, 2, 2);
+        Variable a = argMatrix(args, 0);
+        Variable b = argMatrix(args, 1);
+        size_t m = a.dims[0], k = a.dims[1], n = b.dims[1];
+        if (b.dims[0] != k) {
+            error(filename, args.callee.line, args.callee.col,
+                  "matmul() 维度不匹配: " + std::to_string(m) + "x" + std::to_string(k) +
+                  " 与 " + std::to_string(b.dims[0]) + "x" + std::to_string(n));
+        }
+        Variable out(VarType::ARRAY);
+        out.setDims({m, n});
+        std::vector<double> scratchA, scratchB;
+        matmulKernel(a.numericData(scratchA), b.numericData(scratchB), out.store->nums.data(), m, k, n);
+        return out;
+    }
+
+    
+    Variable builtinTranspose(CallArgs& args) {
+        expectArgs(args, 1, 1);
+        Variable a = argMatrix(args, 0);
+        size_t rows = a.dims[0], cols = a.dims[1];
+        Variable out(VarType::ARRAY);
+        out.setDims({cols, rows});
+        if (a.store->numeric) {
+            std::vector<double> scratch;
+            transposeKernel(a.numericData(scratch), out.store->nums.data(), rows, cols);
+        } else {
+            out.store->toText();
+            a.forEachIndex([&](size_t i, size_t phys) {
+                out.store->texts[(i % cols) * rows + i / cols] = a.store->texts[phys];
+            });
+        }
+        return out;
+    }
+
+    
+    Variable builtinMatvec(CallArgs& args) {
+        expectArgs(args, 2, 2);
+        Variable a = argMatrix(args, 0);
+        Variable x = argVector(args, 1);
+        size_t m = a.dims[0], n = a.dims[1];
+        if (x.dims[0] != n) {
+            error(filename, args.callee.line, args.callee.col,
+                  "matvec() 维度不匹配: 矩阵有 " + std::to_string(n) + " 列，向量长度为 " +
+                  std::to_string(x.dims[0]));
+        }
+        Variable out(VarType::ARRAY);
+        out.setDims({m});
+        std::vector<double> scratchA, scratchX;
+        matvecKernel(a.numericData(scratchA), x.numericData(scratchX), out.store->nums.data(), m, n);
+        return out;
+    }
+
+    
+    Variable builtinOuter(CallArgs& args) {
+        expectArgs(args, 2, 2);
+        Variable x = argVector(args, 0);
+        Variable y = argVector(args, 1);
+        size_t m = x.dims[0], n = y.dims[0];
+        Variable out(VarType::ARRAY);
+        out.setDims({m, n});
+        std::vector<double> scratchX, scratchY;
+        outerKernel(x.numericData(scratchX), y.numericData(scratchY), out.store->nums.data(), m, n);
+        return out;
+    }
+
+    
+    Variable& growableArg(CallArgs& args) {
+        size_t b = args.ranges[0].first, e = args.ranges[0].second;
+        const Token& t = args.tokens[b];
+        if (e - b != 1 || t.type != TokenType::IDENTIFIER) {
+            error(filename, t.line, t.col,
+                  "函数 \'" + args.callee.lexeme + "\' 的第 1 个参数必须是数组变量名");
+        }
+        Variable& arr = arrayVar(t.lexeme, t);
+        if (arr.dims.size() != 1 || arr.isView()) {
+            error(filename, t.line, t.col,
+                  "函数 \'" + args.callee.lexeme + "\' 只能改变一维数组的长度，不能用于多维数组或视图");
+        }
+        auto mapping = arr.store->mapping();
+        if (mapping && mapping->shared) {
+            error(filename, t.line, t.col,
+                  "函数 \'" + args.callee.lexeme + "\' 不能改变文件映射数组的长度: " + mapping->path);
+        }
+        if (arr.store.use_count() > 1) {
+            arr.store = std::make_shared<ArrayStore>(*arr.store);
+            arr.records.reset();
+        }
+        arr.store->densify();
+        return arr;
+    }
+
+    
+    Variable scalarArg(CallArgs& args, size_t i) {
+        Variable v = argValue(args, i);
+        if (v.isArray()) {
+            const Token& t = args.tokens[args.ranges[i].first];
+            error(filename, t.line, t.col,
+                  "函数 \'" + args.callee.lexeme + "\' 的第 " + std::to_string(i + 1) + " 个参数必须是标量");
+        }
+        return v;
+    }
+
+    
+    size_t sizeArg(CallArgs& args, size_t i) {
+        double v = argNumber(args, i);
+        if (v < 0 || v != std::floor(v)) {
+            const Token& t = args.tokens[args.ranges[i].first];
+            error(filename, t.line, t.col,
+                  "函数 \'" + args.callee.lexeme + "\' 的第 " + std::to_string(i + 1) + " 个参数必须是非负整数");
+        }
+        return static_cast<size_t>(v);
+    }
+
+    
+    Variable builtinLen(CallArgs& args) {
+        expectArgs(args, 1, 1);
+        Variable v = argValue(args, 0);
+        if (v.isDict()) return numberResult(static_cast<double>(v.dict->size()));
+        if (v.isRecord()) return numberResult(static_cast<double>(v.dims.empty() ? 1 : v.dims[0]));
+        if (v.isHeap()) return numberResult(static_cast<double>(v.heap->keys.size()));
+        if (v.isDigest()) return numberResult(v.digest->count());
+        expectArray(args, 0, v);
+        return numberResult(static_cast<double>(v.getArraySize()));
+    }
+
+    
+    Variable builtinPush(CallArgs& args) {
+        expectArgs(args, 2, SIZE_MAX);
+        Variable target = argValue(args, 0);
+        if (target.isDigest()) {
+            for (size_t i = 1; i < args.size(); ++i) {
+                Variable v = argValue(args, i);
+                if (v.isArray()) {
+                    std::vector<double> scratch;
+                    const double* p = v.numericData(scratch);
+                    for (size_t j = 0; j < v.elementCount(); ++j) target.digest->add(p[j]);
+                } else {
+                    target.digest->add(v.getNumericValue());
+                }
+            }
+            return numberResult(target.digest->count());
+        }
+        if (target.isHeap()) {
+            expectArgs(args, 2, 3);
+            double key = argNumber(args, 1);
+            if (args.size() == 3) {
+                target.heap->enablePayload();
+                target.heap->push(key, argNumber(args, 2));
+            } else {
+                target.heap->push(key);
+            }
+            return numberResult(static_cast<double>(target.heap->keys.size()));
+        }
+        target = Variable();
+        std::vector<Variable> values;
+        for (size_t i = 1; i < args.size(); ++i) values.push_back(scalarArg(args, i));
+        Variable& arr = growableArg(args);
+        for (const Variable& v : values) {
+            size_t n = arr.store->size();
+            arr.store->insertSlot(n);
+            arr.setPhysical(n, v);
+        }
+        arr.dims[0] = arr.store->size();
+        return numberResult(static_cast<double>(arr.dims[0]));
+    }
+
+    
+    Variable builtinPop(CallArgs& args) {
+        expectArgs(args, 1, 1);
+        Variable target = argValue(args, 0);
+        if (target.isHeap()) {
+            double key = nonEmptyHeap(args, target).keys[0];
+            target.heap->pop();
+            return numberResult(key);
+        }
+        target = Variable();
+        Variable& arr = growableArg(args);
+        if (arr.dims[0] == 0) {
+            error(filename, args.callee.line, args.callee.col, "函数 \'pop\' 不能用于空数组");
+        }
+        size_t last = arr.dims[0] - 1;
+        Variable result = arr.store->numeric ? numberResult(arr.store->nums[last])
+                                             : Variable(VarType::STRING, arr.store->texts[last]);
+        arr.store->erase(last);
+        arr.dims[0] = last;
+        return result;
+    }
+
+    
+    Variable builtinInsert(CallArgs& args) {
+        expectArgs(args, 3, 3);
+        size_t pos = sizeArg(args, 1);
+        Variable v = scalarArg(args, 2);
+        Variable& arr = growableArg(args);
+        if (pos > arr.dims[0]) {
+            error(filename, args.callee.line, args.callee.col,
+                  "插入位置越界: " + std::to_string(pos) + " (数组长度 " + std::to_string(arr.dims[0]) + ")");
+        }
+        arr.store->insertSlot(pos);
+        arr.setPhysical(pos, v);
+        arr.dims[0] = arr.store->size();
+        return numberResult(static_cast<double>(arr.dims[0]));
+    }
+
+    
+    Variable builtinReserve(CallArgs& args) {
+        expectArgs(args, 2, 2);
+        size_t n = sizeArg(args, 1);
+        Variable target = argValue(args, 0);
+        if (target.isHeap()) {
+            target.heap->keys.reserve(n);
+            if (target.heap->hasPayload) target.heap->payloads.reserve(n);
+            return numberResult(static_cast<double>(target.heap->keys.size()));
+        }
+        if (target.isDict()) {
+            target.dict->reserve(n);
+            return numberResult(static_cast<double>(target.dict->size()));
+        }
+        target = Variable();
+        Variable& arr = growableArg(args);
+        arr.store->reserve(n);
+        return numberResult(static_cast<double>(arr.dims[0]));
+    }
+
+    
+    Variable builtinResize(CallArgs& args) {
+        expectArgs(args, 2, 3);
+        size_t n = sizeArg(args, 1);
+        Variable fill = args.size() == 3 ? scalarArg(args, 2) : Variable(VarType::DOUBLE, "0");
+        Variable& arr = growableArg(args);
+        size_t old = arr.dims[0];
+        arr.store->resize(n);
+        for (size_t i = old; i < n; ++i) arr.setPhysical(i, fill);
+        arr.dims[0] = n;
+        return numberResult(static_cast<double>(n));
+    }
+
+    
+    Variable builtinSparse(CallArgs& args) {
+        expectArgs(args, 1, SIZE_MAX);
+        std::vector<size_t> shape;
+        for (size_t i = 0; i < args.size(); ++i) shape.push_back(sizeArg(args, i));
+        Variable out(VarType::ARRAY);
+        out.setSparseDims(shape);
+        return out;
+    }
+
+    
+    Variable builtinNnz(CallArgs& args) {
+        expectArgs(args, 1, 1);
+        Variable arr = argArray(args, 0);
+        if (arr.store->sparse && !arr.isView()) {
+            return numberResult(static_cast<double>(arr.store->cells.size()));
+        }
+        size_t count = 0;
+        arr.forEachIndex([&](size_t, size_t phys) {
+            if (arr.store->numberAt(phys) != 0.0) count++;
+        });
+        return numberResult(static_cast<double>(count));
+    }
+
+    
+    Variable argDict(CallArgs& args, size_t i) {
+        Variable v = argValue(args, i);
+        if (!v.isDict()) {
+            const Token& t = args.tokens[args.ranges[i].first];
+            error(filename, t.line, t.col,
+                  "函数 \'" + args.callee.lexeme + "\' 的第 " + std::to_string(i + 1) + " 个参数必须是字典");
+        }
+        return v;
+    }
+
+    
+    DictKey argKey(CallArgs& args, size_t i) {
+        return dictScalar(argValue(args, i), args.tokens[args.ranges[i].first]);
+    }
+
+    
+    Variable builtinHas(CallArgs& args) {
+        expectArgs(args, 2, 2);
+        Variable d = argDict(args, 0);
+        return numberResult(d.dict->find(argKey(args, 1)) ? 1.0 : 0.0);
+    }
+
+    
+    Variable builtinGet(CallArgs& args) {
+        expectArgs(args, 2, 3);
+        Variable d = argDict(args, 0);
+        DictKey key = argKey(args, 1);
+        const DictKey* value = d.dict->find(key);
+        if (value) return dictValueVar(*value);
+        if (args.size() == 3) return dictValueVar(argKey(args, 2));
+        error(filename, args.callee.line, args.callee.col, "字典中不存在键 \'" + key.toString() + "\'");
+        return Variable();
+    }
+
+    
+    Variable builtinSet(CallArgs& args) {
+        expectArgs(args, 3, 3);
+        Variable d = argDict(args, 0);
+        DictKey key = argKey(args, 1);
+        d.dict->insert(key) = argKey(args, 2);
+        return numberResult(static_cast<double>(d.dict->size()));
+    }
+
+    
+    Variable builtinErase(CallArgs& args) {
+        expectArgs(args, 2, 2);
+        Variable d = argDict(args, 0);
+        return numberResult(d.dict->erase(argKey(args, 1)) ? 1.0 : 0.0);
+    }
+
+    
+    Variable dictColumn(CallArgs& args, bool wantKeys) {
+        expectArgs(args, 1, 1);
+        Variable d = argDict(args, 0);
+        Variable out(VarType::ARRAY);
+        out.setDims({d.dict->size()});
+        size_t i = 0;
+        d.dict->forEach([&](const DictKey& k, const DictKey& v) {
+            const DictKey& item = wantKeys ? k : v;
+            if (item.numeric) out.store->setNumber(i, item.num);
+            else out.store->setText(i, item.text);
+            i++;
+        });
+        return out;
+    }
+
+    
+    Variable builtinKeys(CallArgs& args) {
+        return dictColumn(args, true);
+    }
+
+    
+    Variable builtinValues(CallArgs& args) {
+        return dictColumn(args, false);
+    }
+
+    
+    Variable builtinClear(CallArgs& args) {
+        expectArgs(args, 1, 1);
+        Variable target = argValue(args, 0);
+        if (target.isHeap()) {
+            target.heap->keys.clear();
+            target.heap->payloads.clear();
+            return numberResult(0.0);
+        }
+        Variable d = argDict(args, 0);
+        d.dict->clear();
+        return numberResult(0.0);
+    }
+
+    
+    Variable builtinColumn(CallArgs& args) {
+        expectArgs(args, 2, 2);
+        Variable rec = argValue(args, 0);
+        const Token& at = args.tokens[args.ranges[0].first];
+        if (!rec.isRecord() || rec.dims.empty()) {
+            error(filename, at.line, at.col, "函数 \'column\' 的第 1 个参数必须是记录数组");
+        }
+        const Token& fieldAt = args.tokens[args.ranges[1].first];
+        Token field = fieldAt;
+        field.lexeme = argText(args, 1);
+        size_t slot = rec.records->layout->fieldIndex(field);
+        if (slot == SIZE_MAX) {
+            error(filename, fieldAt.line, fieldAt.col,
+                  "记录类型 \'" + rec.records->layout->name + "\' 没有字段 \'" + field.lexeme + "\'");
+        }
+        Variable out(VarType::ARRAY);
+        out.dims = rec.dims;
+        out.strides = {1};
+        out.store = rec.records->columns[slot];
+        out.records = rec.records;
+        return out;
+    }
+
+    
+    HeapStore& nonEmptyHeap(CallArgs& args, const Variable& target) {
+        if (target.heap->keys.empty()) {
+            error(filename, args.callee.line, args.callee.col,
+                  "函数 \'" + args.callee.lexeme + "\' 不能用于空优先队列");
+        }
+        return *target.heap;
+    }
+
+    
+    Variable argHeap(CallArgs& args, size_t i) {
+        Variable v = argValue(args, i);
+        if (!v.isHeap()) {
+            const Token& t = args.tokens[args.ranges[i].first];
+            error(filename, t.line, t.col,
+                  "函数 \'" + args.callee.lexeme + "\' 的第 " + std::to_string(i + 1) + " 个参数必须是优先队列");
+        }
+        return v;
+    }
+
+    
+    bool argMaxOrder(CallArgs& args, size_t i, bool fallback) {
+        if (i >= args.size()) return fallback;
+        std::string order = argText(args, i);
+        if (order != "min" && order != "max") {
+            const Token& t = args.tokens[args.ranges[i].first];
+            error(filename, t.line, t.col, "顺序参数只能是 \"min\" 或 \"max\"");
+        }
+        return order == "max";
+    }
+
+    
+    Variable builtinPeek(CallArgs& args) {
+        expectArgs(args, 1, 1);
+        Variable h = argHeap(args, 0);
+        return numberResult(nonEmptyHeap(args, h).keys[0]);
+    }
+
+    
+    Variable builtinPayload(CallArgs& args) {
+        expectArgs(args, 1, 1);
+        Variable h = argHeap(args, 0);
+        HeapStore& store = nonEmptyHeap(args, h);
+        return numberResult(store.hasPayload ? store.payloads[0] : 0.0);
+    }
+
+    
+    Variable builtinHeapify(CallArgs& args) {
+        expectArgs(args, 1, 3);
+        Variable keys = argArray(args, 0);
+        Variable out(VarType::HEAP, "");
+        out.heap = std::make_shared<HeapStore>();
+        out.heap->maxHeap = argMaxOrder(args, 1, false);
+        std::vector<double> scratch;
+        const double* p = keys.numericData(scratch);
+        out.heap->keys.assign(p, p + keys.elementCount());
+        if (args.size() == 3) {
+            Variable payloads = argArray(args, 2);
+            if (payloads.elementCount() != keys.elementCount()) {
+                error(filename, args.callee.line, args.callee.col, "heapify 的键与载荷数量不一致");
+            }
+            std::vector<double> payloadScratch;
+            const double* q = payloads.numericData(payloadScratch);
+            out.heap->payloads.assign(q, q + payloads.elementCount());
+            out.heap->hasPayload = true;
+        }
+        out.heap->heapify();
+        return out;
+    }
+
+    
+    Variable builtinTopk(CallArgs& args) {
+        expectArgs(args, 2, 3);
+        Variable arr = argArray(args, 0);
+        size_t k = std::min(sizeArg(args, 1), arr.elementCount());
+        bool largest = argMaxOrder(args, 2, true);
+        std::vector<double> scratch;
+        const double* p = arr.numericData(scratch);
+        HeapStore window;
+        window.maxHeap = !largest;
+        window.keys.reserve(k + 1);
+        size_t n = arr.elementCount();
+        for (size_t i = 0; i < n && k > 0; ++i) {
+            if (std::isnan(p[i])) continue;
+            if (window.keys.size() < k) {
+                window.push(p[i]);
+            } else if (window.before(window.keys[0], p[i])) {
+                window.keys[0] = p[i];
+                window.siftDown(0);
+            }
+        }
+        Variable out(VarType::ARRAY);
+        out.setDims({window.keys.size()});
+        for (size_t i = window.keys.size(); i-- > 0;) {
+            out.store->nums[i] = window.keys[0];
+            window.pop();
+        }
+        return out;
+    }
+
+    
+    size_t searchBound(const Variable& arr, const Variable& key, bool upper) {
+        if (arr.isIndex()) {
+            double x = key.getNumericValue();
+            return upper ? arr.sorted->bound<true>(x) : arr.sorted->bound<false>(x);
+        }
+        size_t n = arr.dims[0];
+        size_t stride = arr.strides[0];
+        const ArrayStore& store = *arr.store;
+        if (store.numeric && !store.sparse) {
+            double x = key.getNumericValue();
+            const double* base = store.nums.data() + arr.offset;
+            if (stride == 1) {
+                return upper ? std::upper_bound(base, base + n, x) - base
+                             : std::lower_bound(base, base + n, x) - base;
+            }
+            size_t lo = 0, hi = n;
+            while (lo < hi) {
+                size_t mid = lo + (hi - lo) / 2;
+                double v = base[mid * stride];
+                if (upper ? !(x < v) : v < x) lo = mid + 1;
+                else hi = mid;
+            }
+            return lo;
+        }
+        double x = key.getNumericValue();
+        size_t lo = 0, hi = n;
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+            size_t phys = arr.offset + mid * stride;
+            bool right;
+            if (store.numeric) {
+                double v = store.numberAt(phys);
+                right = upper ? !(x < v) : v < x;
+            } else {
+                const std::string& v = store.texts[phys];
+                right = upper ? !(key.value < v) : v < key.value;
+            }
+            if (right) lo = mid + 1;
+            else hi = mid;
+        }
+        return lo;
+    }
+
+    
+    void searchArgs(CallArgs& args, Variable& target, Variable& key) {
+        expectArgs(args, 2, 2);
+        target = argValue(args, 0);
+        if (!target.isIndex()) {
+            const Token& t = args.tokens[args.ranges[0].first];
+            if (!target.isArray()) {
+                error(filename, t.line, t.col,
+                      "函数 \'" + args.callee.lexeme + "\' 的第 1 个参数必须是数组");
+            }
+            if (target.dims.size() != 1) {
+                error(filename, t.line, t.col,
+                      "函数 \'" + args.callee.lexeme + "\' 的第 1 个参数必须是一维数组");
+            }
+        }
+        key = scalarArg(args, 1);
+    }
+
+    
+    Variable builtinLowerBound(CallArgs& args) {
+        Variable arr, key;
+        searchArgs(args, arr, key);
+        return numberResult(static_cast<double>(searchBound(arr, key, false)));
+    }
+
+    
+    Variable builtinUpperBound(CallArgs& args) {
+        Variable arr, key;
+        searchArgs(args, arr, key);
+        return numberResult(static_cast<double>(searchBound(arr, key, true)));
+    }
+
+    
+    Variable builtinBinarySearch(CallArgs& args) {
+        Variable arr, key;
+        searchArgs(args, arr, key);
+        return numberResult(searchBound(arr, key, true) > searchBound(arr, key, false) ? 1.0 : 0.0);
+    }
+
+    
+    Variable builtinEqualRange(CallArgs& args) {
+        Variable arr, key;
+        searchArgs(args, arr, key);
+        Variable out(VarType::ARRAY);
+        out.setDims({2});
+        out.store->nums[0] = static_cast<double>(searchBound(arr, key, false));
+        out.store->nums[1] = static_cast<double>(searchBound(arr, key, true));
+        return out;
+    }
+
+    
+    Variable builtinSortedIndex(CallArgs& args) {
+        expectArgs(args, 1, 1);
+        Variable arr = argVector(args, 0);
+        if (!arr.store->numeric) {
+            const Token& t = args.tokens[args.ranges[0].first];
+            error(filename, t.line, t.col, "sortedindex 只支持数值数组");
+        }
+        std::vector<double> scratch;
+        auto index = std::make_shared<SortedIndex>();
+        index->build(arr.numericData(scratch), arr.elementCount());
+        Variable out(VarType::INDEX, "");
+        out.sorted = index;
+        return out;
+    }
+
+    
+    Variable builtinBetween(CallArgs& args) {
+        expectArgs(args, 3, 3);
+        Variable target = argValue(args, 0);
+        if (!target.isIndex()) {
+            const Token& t = args.tokens[args.ranges[0].first];
+            error(filename, t.line, t.col, "函数 \'between\' 的第 1 个参数必须是 sortedindex 结果");
+        }
+        size_t lo = target.sorted->bound<false>(argNumber(args, 1));
+        size_t hi = target.sorted->bound<true>(argNumber(args, 2));
+        Variable out(VarType::ARRAY);
+        out.setDims({hi > lo ? hi - lo : 0});
+        for (size_t i = lo; i < hi; ++i) {
+            out.store->nums[i - lo] = static_cast<double>(target.sorted->order[i]);
+        }
+        return out;
+    }
+
+    
+    double groupResult(const GroupAcc& acc, const std::string& op) {
+        if (op == "count") return static_cast<double>(acc.count);
+        if (op == "sum") return acc.sum;
+        if (op == "min") return acc.min;
+        if (op == "max") return acc.max;
+        return acc.sum / acc.count;
+    }
+
+    
+    Variable builtinGroupby(CallArgs& args) {
+        expectArgs(args, 2, 3);
+        Variable keys = argVector(args, 0);
+        Variable second = argValue(args, 1);
+        bool hasValues = second.isArray();
+        std::string op = hasValues ? (args.size() == 3 ? argText(args, 2) : "sum") : second.value;
+        if (!hasValues && args.size() == 3) {
+            error(filename, args.callee.line, args.callee.col, "groupby 的第 2 个参数必须是值数组");
+        }
+        if (op != "count" && op != "sum" && op != "min" && op != "max" && op != "mean") {
+            error(filename, args.callee.line, args.callee.col,
+                  "groupby 的聚合方式只能是 count、sum、min、max 或 mean，实际为 \'" + op + "\'");
+        }
+        if (!hasValues && op != "count") {
+            error(filename, args.callee.line, args.callee.col, "groupby 的 " + op + " 聚合需要值数组");
+        }
+        size_t n = keys.dims[0];
+        std::vector<double> scratch;
+        const double* values = nullptr;
+        if (hasValues) {
+            expectVector(args, 1, second);
+            if (second.dims[0] != n) {
+                error(filename, args.callee.line, args.callee.col, "groupby 的键数组与值数组长度不一致");
+            }
+            values = second.numericData(scratch);
+        }
+
+        Variable out(VarType::DICT, "");
+        out.dict = std::make_shared<DictStore>();
+        const ArrayStore& store = *keys.store;
+        size_t offset = keys.offset, stride = keys.strides[0];
+        if (store.numeric) {
+            auto groups = groupKernel<double>(n, [&](size_t i, double& k) {
+                k = store.numberAt(offset + i * stride);
+                if (std::isnan(k)) return false;
+                if (k == 0.0) k = 0.0;
+                return true;
+            }, values);
+            std::vector<std::pair<double, GroupAcc>> sorted(groups.begin(), groups.end());
+            std::sort(sorted.begin(), sorted.end(),
+                      [](const std::pair<double, GroupAcc>& a, const std::pair<double, GroupAcc>& b) { return a.first < b.first; });
+            out.dict->reserve(sorted.size());
+            for (const auto& g : sorted) {
+                DictKey k;
+                k.num = g.first;
+                out.dict->insert(k).num = groupResult(g.second, op);
+            }
+        } else {
+            auto groups = groupKernel<std::string>(n, [&](size_t i, std::string& k) {
+                k = store.texts[offset + i * stride];
+                return true;
+            }, values);
+            std::vector<std::pair<std::string, GroupAcc>> sorted(groups.begin(), groups.end());
+            std::sort(sorted.begin(), sorted.end(),
+                      [](const std::pair<std::string, GroupAcc>& a, const std::pair<std::string, GroupAcc>& b) { return a.first < b.first; });
+            out.dict->reserve(sorted.size());
+            for (const auto& g : sorted) {
+                DictKey k;
+                k.numeric = false;
+                k.text = g.first;
+                out.dict->insert(k).num = groupResult(g.second, op);
+            }
+        }
+        return out;
+    }
+
+    
+    Variable builtinHistogram(CallArgs& args) {
+        expectArgs(args, 2, 4);
+        if (args.size() == 3) {
+            error(filename, args.callee.line, args.callee.col, "histogram 需要同时给出下界和上界");
+        }
+        Variable arr = argArray(args, 0);
+        size_t bins = sizeArg(args, 1);
+        if (bins == 0) {
+            error(filename, args.callee.line, args.callee.col, "histogram 的分箱数量必须大于 0");
+        }
+        std::vector<double> scratch;
+        size_t n;
+        const double* p = arr.foldedData(scratch, n);
+        double lo, hi;
+        if (args.size() == 4) {
+            lo = argNumber(args, 2);
+            hi = argNumber(args, 3);
+        } else {
+            lo = n ? reduceExtreme<false>(p, n) : 0.0;
+            hi = n ? reduceExtreme<true>(p, n) : 0.0;
+        }
+        if (!(hi >= lo)) {
+            error(filename, args.callee.line, args.callee.col, "histogram 的上界必须不小于下界");
+        }
+        Variable out(VarType::ARRAY);
+        out.setDims({bins});
+        double* counts = out.store->nums.data();
+        if (!arr.isSparse()) {
+            histogramKernel(p, n, lo, hi, bins, counts);
+            return out;
+        }
+        size_t zeros = arr.elementCount() - arr.store->cells.size();
+        if (zeros > 0) n--;
+        histogramKernel(p, n, lo, hi, bins, counts);
+        if (zeros > 0) {
+            std::vector<double> zeroBin(bins, 0.0);
+            histogramKernel(p + n, 1, lo, hi, bins, zeroBin.data());
+            for (size_t k = 0; k < bins; ++k) counts[k] += zeroBin[k] * zeros;
+        }
+        return out;
+    }
+
+    
+    template <typename Kernel>
+    Variable seriesResult(CallArgs& args, size_t outArg, const Variable& src, size_t len, Kernel kernel) {
+        if (args.size() <= outArg) {
+            Variable out(VarType::ARRAY);
+            out.setDims({len});
+            kernel(out.store->nums.data());
+            return out;
+        }
+        Variable target = argVector(args, outArg);
+        if (target.dims[0] != len) {
+            const Token& t = args.tokens[args.ranges[outArg].first];
+            error(filename, t.line, t.col,
+                  "函数 \'" + args.callee.lexeme + "\' 的输出数组长度应为 " + std::to_string(len) +
+                  "，实际为 " + std::to_string(target.dims[0]));
+        }
+        if (target.store != src.store && target.store->numeric && !target.store->sparse && target.strides[0] == 1) {
+            kernel(target.store->nums.data() + target.offset);
+            return target;
+        }
+        std::vector<double> tmp(len);
+        kernel(tmp.data());
+        target.forEachIndex([&](size_t i, size_t phys) { target.store->setNumber(phys, tmp[i]); });
+        return target;
+    }
+
+    
+    size_t windowArg(CallArgs& args, const Variable& arr) {
+        size_t w = sizeArg(args, 1);
+        if (w == 0 || w > arr.dims[0]) {
+            const Token& t = args.tokens[args.ranges[1].first];
+            error(filename, t.line, t.col,
+                  "窗口大小必须在 1 到数组长度 " + std::to_string(arr.dims[0]) + " 之间");
+        }
+        return w;
+    }
 
-                size_t braceStart = ip + 14;
-                if (braceStart >= tokens.size() || tokens[braceStart].type != TokenType::LBRACE) {
-                    error(filename, t.line, t.col, "for 循环缺少 {");
-                }
-                size_t braceEnd = braceStart + 1;
-                int depth = 1;
-                while (braceEnd < tokens.size() && depth > 0) {
-                    if (tokens[braceEnd].type == TokenType::LBRACE) depth++;
-                    else if (tokens[braceEnd].type == TokenType::RBRACE) depth--;
-                    braceEnd++;
-                }
-                if (depth != 0) error(filename, t.line, t.col, "for 循环缺少闭合的 }");
+    
+    Variable builtinRollingSum(CallArgs& args) {
+        expectArgs(args, 2, 3);
+        Variable arr = argVector(args, 0);
+        size_t w = windowArg(args, arr), n = arr.dims[0];
+        std::vector<double> scratch;
+        const double* p = arr.numericData(scratch);
+        return seriesResult(args, 2, arr, n - w + 1, [&](double* out) { rollingSumKernel(p, n, w, out); });
+    }
 
-                setVar(initVar, VarType::INT, std::to_string(initVal));
-                while (true) {
-                    if (!hasVar(condVar)) {
-                        error(filename, tokens[ip+7].line, tokens[ip+7].col,
-                              "变量 \'" + condVar + "\' 未声明");
-                    }
-                    double cur = getNumericVar(condVar);
-                    bool cond = false;
-                    if (op == "<") cond = (cur < limit);
-                    else if (op == "<=") cond = (cur <= limit);
-                    else if (op == ">") cond = (cur > limit);
-                    else if (op == ">=") cond = (cur >= limit);
-                    else if (op == "==") cond = (cur == limit);
-                    if (!cond) break;
+    
+    Variable builtinRollingMean(CallArgs& args) {
+        expectArgs(args, 2, 3);
+        Variable arr = argVector(args, 0);
+        size_t w = windowArg(args, arr), n = arr.dims[0];
+        std::vector<double> scratch;
+        const double* p = arr.numericData(scratch);
+        return seriesResult(args, 2, arr, n - w + 1, [&](double* out) {
+            rollingSumKernel(p, n, w, out);
+            double inv = 1.0 / w;
+            for (size_t i = 0; i + w <= n; ++i) out[i] *= inv;
+        });
+    }
 
-                    std::vector<Token> body(tokens.begin() + braceStart + 1, tokens.begin() + braceEnd - 1);
-                    Interpreter sub(filename);
-                    sub.vars = vars;
-                    sub.execute(body);
-                    vars = sub.vars;
+    
+    Variable builtinRollingMin(CallArgs& args) {
+        expectArgs(args, 2, 3);
+        Variable arr = argVector(args, 0);
+        size_t w = windowArg(args, arr), n = arr.dims[0];
+        std::vector<double> scratch;
+        const double* p = arr.numericData(scratch);
+        return seriesResult(args, 2, arr, n - w + 1, [&](double* out) { rollingExtremeKernel<false>(p, n, w, out); });
+    }
 
-                    if (!hasVar(updateVar)) {
-                        error(filename, tokens[ip+11].line, tokens[ip+11].col,
-                              "变量 \'" + updateVar + "\' 未声明");
-                    }
-                    double current_dbl = getNumericVar(updateVar);
-                    setVar(updateVar, VarType::INT, std::to_string(static_cast<int>(current_dbl) + 1));
-                }
-                ip = braceEnd;
-                continue;
-            }
+    
+    Variable builtinRollingMax(CallArgs& args) {
+        expectArgs(args, 2, 3);
+        Variable arr = argVector(args, 0);
+        size_t w = windowArg(args, arr), n = arr.dims[0];
+        std::vector<double> scratch;
+        const double* p = arr.numericData(scratch);
+        return seriesResult(args, 2, arr, n - w + 1, [&](double* out) { rollingExtremeKernel<true>(p, n, w, out); });
+    }
 
-            
-            if (t.type == TokenType::FINISH && ip + 4 < tokens.size() &&
-                tokens[ip+1].type == TokenType::LPAREN &&
-                tokens[ip+2].type == TokenType::IDENTIFIER &&
-                tokens[ip+3].type == TokenType::RPAREN &&
-                tokens[ip+4].type == TokenType::SEMICOLON) {
+    
+    Variable builtinEwma(CallArgs& args) {
+        expectArgs(args, 2, 3);
+        Variable arr = argVector(args, 0);
+        double alpha = argNumber(args, 1);
+        if (!(alpha > 0.0 && alpha <= 1.0)) {
+            const Token& t = args.tokens[args.ranges[1].first];
+            error(filename, t.line, t.col, "ewma 的平滑系数必须在 (0, 1] 之间");
+        }
+        size_t n = arr.dims[0];
+        std::vector<double> scratch;
+        const double* p = arr.numericData(scratch);
+        return seriesResult(args, 2, arr, n, [&](double* out) { ewmaKernel(p, n, alpha, out); });
+    }
 
-                std::string funcName = tokens[ip+2].lexeme;
-                if (funcName != "main") {
-                    error(filename, tokens[ip+2].line, tokens[ip+2].col,
-                          "finish 语句必须写为 finish(main); 其他名称不被允许");
-                }
-                exit(0);
+    
+    Variable builtinDiff(CallArgs& args) {
+        expectArgs(args, 1, 3);
+        Variable arr = argVector(args, 0);
+        size_t lag = args.size() >= 2 ? sizeArg(args, 1) : 1;
+        size_t n = arr.dims[0];
+        if (lag == 0 || lag > n) {
+            error(filename, args.callee.line, args.callee.col, "diff 的间隔必须在 1 到数组长度之间");
+        }
+        std::vector<double> scratch;
+        const double* p = arr.numericData(scratch);
+        return seriesResult(args, 2, arr, n - lag, [&](double* out) { diffKernel(p, n, lag, out); });
+    }
+
+    
+    Variable builtinCumsum(CallArgs& args) {
+        expectArgs(args, 1, 2);
+        Variable arr = argVector(args, 0);
+        size_t n = arr.dims[0];
+        std::vector<double> scratch;
+        const double* p = arr.numericData(scratch);
+        return seriesResult(args, 1, arr, n, [&](double* out) { prefixSum(p, out, n); });
+    }
+
+    
+    void quantilesOf(CallArgs& args, const Variable& src, const double* qs, size_t m, double* out) {
+        for (size_t j = 0; j < m; ++j) {
+            if (!(qs[j] >= 0.0 && qs[j] <= 1.0)) {
+                error(filename, args.callee.line, args.callee.col, "分位数必须在 0 到 1 之间");
+            }
+        }
+        if (src.isDigest()) {
+            if (src.digest->count() == 0) {
+                error(filename, args.callee.line, args.callee.col,
+                      "函数 \'" + args.callee.lexeme + "\' 不能用于空 tdigest");
             }
+            for (size_t j = 0; j < m; ++j) out[j] = src.digest->quantile(qs[j]);
+            return;
+        }
+        if (src.isSparse()) {
+            if (!sparseQuantiles(src, qs, m, out)) {
+                error(filename, args.callee.line, args.callee.col,
+                      "函数 \'" + args.callee.lexeme + "\' 不能用于空数组");
+            }
+            return;
+        }
+        std::vector<double> scratch;
+        if (!quantileKernel(src.numericData(scratch), src.elementCount(), qs, m, out)) {
+            error(filename, args.callee.line, args.callee.col,
+                  "函数 \'" + args.callee.lexeme + "\' 不能用于空数组");
+        }
+    }
 
-            
-            if (t.type == TokenType::ACCEPT && ip + 4 < tokens.size() &&
-                tokens[ip+1].type == TokenType::IDENTIFIER &&
-                tokens[ip+2].lexeme == "function" &&
-                tokens[ip+3].type == TokenType::DOT &&
-                tokens[ip+4].type == TokenType::IDENTIFIER &&
-                tokens[ip+4].lexeme == "main") {
+    
+    bool sparseQuantiles(const Variable& arr, const double* qs, size_t m, double* out) {
+        std::vector<double> v;
+        v.reserve(arr.store->cells.size());
+        for (const auto& cell : arr.store->cells) {
+            if (!std::isnan(cell.second)) v.push_back(cell.second);
+        }
+        size_t zeros = arr.elementCount() - arr.store->cells.size();
+        size_t total = v.size() + zeros;
+        if (total == 0) return false;
+        std::sort(v.begin(), v.end());
+        size_t neg = std::lower_bound(v.begin(), v.end(), 0.0) - v.begin();
+        auto at = [&](size_t r) { return r < neg ? v[r] : r < neg + zeros ? 0.0 : v[r - zeros]; };
+        size_t last = total - 1;
+        for (size_t j = 0; j < m; ++j) {
+            double h = qs[j] * last;
+            size_t lo = static_cast<size_t>(std::floor(h));
+            size_t hi = std::min(lo + 1, last);
+            out[j] = at(lo) + (h - lo) * (at(hi) - at(lo));
+        }
+        return true;
+    }
 
-                size_t acceptStart = ip + 5;
-                while (acceptStart < tokens.size() && tokens[acceptStart].type != TokenType::PIPE) {
-                    acceptStart++;
-                }
+    
+    Variable quantileSource(CallArgs& args) {
+        Variable src = argValue(args, 0);
+        if (!src.isDigest()) expectArray(args, 0, src);
+        return src;
+    }
 
-                if (acceptStart < tokens.size() && tokens[acceptStart].type == TokenType::PIPE) {
-                    acceptStart++;
-                    if (acceptStart + 1 < tokens.size() &&
-                        tokens[acceptStart].type == TokenType::IDENTIFIER &&
-                        tokens[acceptStart].lexeme == "set" &&
-                        tokens[acceptStart+1].type == TokenType::IDENTIFIER &&
-                        (acceptStart + 2 >= tokens.size() || tokens[acceptStart+2].type == TokenType::SEMICOLON)) {
+    
+    Variable builtinMedian(CallArgs& args) {
+        expectArgs(args, 1, 1);
+        double q = 0.5, r;
+        quantilesOf(args, quantileSource(args), &q, 1, &r);
+        return numberResult(r);
+    }
 
-                        std::string varName = tokens[acceptStart+1].lexeme;
+    
+    Variable builtinQuantile(CallArgs& args) {
+        expectArgs(args, 2, 2);
+        double q = argNumber(args, 1), r;
+        quantilesOf(args, quantileSource(args), &q, 1, &r);
+        return numberResult(r);
+    }
 
-                        
-                        if (!hasVar(varName)) {
-                            error(filename, tokens[acceptStart+1].line, tokens[acceptStart+1].col,
-                                  "变量 \'" + varName + "\' 未声明，accept 目标必须已声明");
-                        }
+    
+    Variable builtinQuantiles(CallArgs& args) {
+        expectArgs(args, 2, 2);
+        Variable src = quantileSource(args);
+        Variable qs = argArray(args, 1);
+        std::vector<double> scratch;
+        const double* q = qs.numericData(scratch);
+        Variable out(VarType::ARRAY);
+        out.setDims(qs.dims);
+        quantilesOf(args, src, q, qs.elementCount(), out.store->nums.data());
+        return out;
+    }
 
-                        auto it = vars.find("_args");
-                        if (it != vars.end()) {
-                            vars[varName] = it->second;
-                        } else {
-                            setVar(varName, VarType::OMNI, "");
-                        }
+    
+    Variable builtinTdigest(CallArgs& args) {
+        expectArgs(args, 0, 2);
+        Variable out(VarType::DIGEST, "");
+        out.digest = std::make_shared<TDigest>();
+        size_t next = 0;
+        Variable data;
+        if (args.size() > 0) {
+            data = argValue(args, 0);
+            if (data.isArray()) next = 1;
+        }
+        if (args.size() > next) {
+            out.digest->compression = next == 0 ? data.getNumericValue() : argNumber(args, next);
+            if (!(out.digest->compression >= 10)) {
+                error(filename, args.callee.line, args.callee.col, "tdigest 的压缩参数不能小于 10");
+            }
+            if (next + 1 < args.size()) {
+                error(filename, args.callee.line, args.callee.col, "tdigest 参数格式为 tdigest([数组][, 压缩参数])");
+            }
+        }
+        if (next == 1) {
+            std::vector<double> scratch;
+            const double* p = data.numericData(scratch);
+            for (size_t i = 0; i < data.elementCount(); ++i) out.digest->add(p[i]);
+        }
+        return out;
+    }
 
-                        ip = acceptStart + 2;
-                        if (ip < tokens.size() && tokens[ip].type == TokenType::SEMICOLON) {
-                            ip++;
-                        }
+    
+    std::shared_ptr<CsvReader> openCsv(CallArgs& args, size_t delimArg, size_t typesArg) {
+        std::string path = argText(args, 0);
+        auto reader = std::make_shared<CsvReader>();
+        if (!reader->open(path)) {
+            error(filename, args.callee.line, args.callee.col, "无法打开 CSV 文件 \'" + path + "\'");
+        }
+        if (path.size() >= 4 && path.compare(path.size() - 4, 4, ".tsv") == 0) reader->delim = '\t';
+        if (args.size() > delimArg) {
+            std::string d = argText(args, delimArg);
+            if (d == "tab" || d == "\\t") d = "\t";
+            if (d.size() != 1 || d[0] == '"' || d[0] == '\n' || d[0] == '\r') {
+                error(filename, args.callee.line, args.callee.col, "CSV 分隔符必须是单个字符，例如 \",\" 或 \"tab\"");
+            }
+            reader->delim = d[0];
+        }
+        if (!reader->nextRecord()) {
+            error(filename, args.callee.line, args.callee.col,
+                  reader->problem.empty() ? "CSV 文件 \'" + path + "\' 缺少表头" : reader->problem);
+        }
+        auto layout = std::make_shared<RecordLayout>();
+        size_t slash = path.find_last_of('/');
+        layout->name = slash == std::string::npos ? path : path.substr(slash + 1);
+        for (std::string_view f : reader->fields) {
+            std::string field(f);
+            if (field.empty() || std::find(layout->fields.begin(), layout->fields.end(), field) != layout->fields.end()) {
+                error(filename, args.callee.line, args.callee.col, "CSV 表头字段为空或重复: \'" + field + "\'");
+            }
+            layout->fields.push_back(field);
+        }
+        reader->layout = layout;
+        reader->types.assign(layout->fields.size(), 'a');
+        if (args.size() > typesArg) {
+            std::string types = argText(args, typesArg);
+            if (types.size() != layout->fields.size() ||
+                types.find_first_not_of("nsa") != std::string::npos) {
+                error(filename, args.callee.line, args.callee.col,
+                      "CSV 列类型应为每列一个字符 (n 数字, s 字符串, a 自动)，共 " +
+                      std::to_string(layout->fields.size()) + " 列");
+            }
+            reader->types = types;
+        }
+        return reader;
+    }
+
+    
+    Variable readCsvRows(CallArgs& args, CsvReader& reader, size_t limit) {
+        size_t width = reader.layout->fields.size();
+        std::vector<std::shared_ptr<ArrayStore>> columns(width);
+        for (size_t c = 0; c < width; ++c) {
+            columns[c] = std::make_shared<ArrayStore>();
+            columns[c]->numeric = reader.types[c] != 's';
+        }
+        size_t rows = 0;
+        while (rows < limit && reader.nextRecord()) {
+            if (reader.fields.size() != width) {
+                error(filename, args.callee.line, args.callee.col,
+                      reader.path + " 第 " + std::to_string(reader.line) + " 行有 " +
+                      std::to_string(reader.fields.size()) + " 个字段，表头有 " + std::to_string(width) + " 个");
+            }
+            for (size_t c = 0; c < width; ++c) {
+                std::string_view f = reader.fields[c];
+                ArrayStore& col = *columns[c];
+                if (col.numeric) {
+                    double v = 0;
+                    const char* first = f.data();
+                    const char* last = first + f.size();
+                    if (first != last && *first == '+') ++first;
+                    auto res = std::from_chars(first, last, v);
+                    if (f.empty() || (res.ec == std::errc() && res.ptr == last)) {
+                        col.nums.push_back(v);
                         continue;
                     }
+                    if (reader.types[c] == 'n') {
+                        error(filename, args.callee.line, args.callee.col,
+                              reader.path + " 第 " + std::to_string(reader.line) + " 行的字段 \'" +
+                              reader.layout->fields[c] + "\' 不是数字: " + std::string(f));
+                    }
+                    col.toText();
+                    col.texts.reserve(rows + 1);
+                    reader.types[c] = 's';
                 }
-
-                error(filename, t.line, t.col, "accept>function.main 语法错误");
+                col.texts.emplace_back(f);
             }
+            rows++;
+        }
+        if (!reader.problem.empty()) {
+            error(filename, args.callee.line, args.callee.col, reader.path + ": " + reader.problem);
+        }
+        auto store = std::make_shared<RecordStore>(reader.layout, 0);
+        store->count = rows;
+        store->columns = std::move(columns);
+        Variable out(VarType::RECORD, "");
+        out.dims = {rows};
+        out.records = store;
+        return out;
+    }
 
-            ip++;
+    
+    Variable builtinReadcsv(CallArgs& args) {
+        expectArgs(args, 1, 3);
+        auto reader = openCsv(args, 1, 2);
+        return readCsvRows(args, *reader, SIZE_MAX);
+    }
+
+    
+    Variable builtinCsvopen(CallArgs& args) {
+        expectArgs(args, 2, 4);
+        size_t rows = sizeArg(args, 1);
+        if (rows == 0) {
+            error(filename, args.callee.line, args.callee.col, "csvopen 每块的行数必须大于 0");
         }
+        Variable out(VarType::CSV, "");
+        out.csv = openCsv(args, 2, 3);
+        out.csv->chunkRows = rows;
+        return out;
     }
 
     
-    void parseOutputStatement(const std::vector<Token>& tokens) {
-        if (tokens.empty()) return;
-        size_t i = 0;
-        if (tokens[i].type != TokenType::OUTPUT_REDIRECT) {
-            error(filename, tokens[i].line, tokens[i].col, "输出语句必须以output开始");
+    Variable builtinCsvnext(CallArgs& args) {
+        expectArgs(args, 1, 1);
+        Variable src = argValue(args, 0);
+        if (!src.isCsv()) {
+            const Token& at = args.tokens[args.ranges[0].first];
+            error(filename, at.line, at.col, "函数 \'csvnext\' 的参数必须是 csvopen 返回的读取器");
         }
-        i++;
-        bool newline = false;
-        std::string outputContent;
-        while (i < tokens.size()) {
-            if (tokens[i].type == TokenType::OUTLB) {
-                newline = true;
-                i++;
-                continue;
+        return readCsvRows(args, *src.csv, src.csv->chunkRows);
+    }
+
+    
+    Variable builtinSave(CallArgs& args) {
+        expectArgs(args, 2, 2);
+        Variable arr = argArray(args, 0);
+        std::string path = argText(args, 1);
+        size_t count = arr.elementCount();
+
+        std::vector<double> scratch;
+        std::string blob;
+        if (arr.store->numeric || arr.store->sparse) {
+            const char* data = reinterpret_cast<const char*>(arr.numericData(scratch));
+            writeArrayFile(args, path, arr.dims, ArrayFileHeader::FLOAT64, data, count * sizeof(double));
+        } else {
+            arr.forEachIndex([&](size_t, size_t phys) {
+                const std::string& text = arr.store->texts[phys];
+                uint64_t n = text.size();
+                blob.append(reinterpret_cast<const char*>(&n), sizeof(n));
+                blob += text;
+            });
+            writeArrayFile(args, path, arr.dims, ArrayFileHeader::TEXT, blob.data(), blob.size());
+        }
+        return numberResult(static_cast<double>(count));
+    }
+
+    
+    void writeArrayFile(CallArgs& args, const std::string& path, const std::vector<size_t>& shape,
+                        uint32_t dtype, const char* data, size_t bytes) {
+        ArrayFileHeader header = {};
+        memcpy(header.magic, ArrayFileHeader::MAGIC, sizeof(header.magic));
+        header.version = ArrayFileHeader::VERSION;
+        header.byteOrder = ArrayFileHeader::ENDIAN_MARK;
+        header.dtype = dtype;
+        header.rank = static_cast<uint32_t>(shape.size());
+        header.count = 1;
+        for (size_t d : shape) header.count *= d;
+        size_t dimBytes = shape.size() * sizeof(uint64_t);
+        header.dataOffset = (sizeof(header) + dimBytes + ArrayFileHeader::ALIGN - 1) / ArrayFileHeader::ALIGN * ArrayFileHeader::ALIGN;
+        header.dataBytes = bytes;
+
+        std::vector<uint64_t> dims(shape.begin(), shape.end());
+        std::string tmp = path + ".tmp";
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            error(filename, args.callee.line, args.callee.col, "无法写入文件 \'" + path + "\'");
+        }
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(dims.data()), dimBytes);
+        std::string pad(header.dataOffset - sizeof(header) - dimBytes, '\0');
+        out.write(pad.data(), pad.size());
+        if (data) out.write(data, bytes);
+        out.close();
+        bool ok = static_cast<bool>(out);
+        if (ok && !data) ok = truncate(tmp.c_str(), static_cast<off_t>(header.dataOffset + bytes)) == 0;
+        if (!ok || std::rename(tmp.c_str(), path.c_str()) != 0) {
+            std::remove(tmp.c_str());
+            error(filename, args.callee.line, args.callee.col, "写入文件 \'" + path + "\' 失败");
+        }
+    }
+
+    
+    Variable builtinLoad(CallArgs& args) {
+        expectArgs(args, 1, 1);
+        return mapArrayFile(args, argText(args, 0), false);
+    }
+
+    
+    Variable mapArrayFile(CallArgs& args, const std::string& path, bool shared) {
+        auto fail = [&](const std::string& why) {
+            error(filename, args.callee.line, args.callee.col, "无法加载数组文件 \'" + path + "\': " + why);
+        };
+
+        int fd = ::open(path.c_str(), shared ? O_RDWR : O_RDONLY);
+        if (fd < 0) fail(shared ? "文件不存在或没有读写权限" : "文件不存在或没有读取权限");
+        struct stat st;
+        if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(ArrayFileHeader)) {
+            ::close(fd);
+            fail("文件太小，不是数组文件");
+        }
+        auto mapping = std::make_shared<FileMapping>();
+        mapping->path = path;
+        mapping->shared = shared;
+        mapping->length = static_cast<size_t>(st.st_size);
+        mapping->base = mmap(nullptr, mapping->length, PROT_READ | PROT_WRITE, shared ? MAP_SHARED : MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (mapping->base == MAP_FAILED) fail("mmap 失败");
+
+        ArrayFileHeader header;
+        memcpy(&header, mapping->base, sizeof(header));
+        if (memcmp(header.magic, ArrayFileHeader::MAGIC, sizeof(header.magic)) != 0) fail("文件头标识不正确");
+        if (header.version != ArrayFileHeader::VERSION) fail("不支持的格式版本 " + std::to_string(header.version));
+        if (header.byteOrder != ArrayFileHeader::ENDIAN_MARK) fail("字节序与本机不一致");
+        size_t dimBytes = static_cast<size_t>(header.rank) * sizeof(uint64_t);
+        if (header.rank == 0 || sizeof(header) + dimBytes > header.dataOffset ||
+            header.dataOffset % ArrayFileHeader::ALIGN != 0 ||
+            header.dataOffset > mapping->length || header.dataBytes > mapping->length - header.dataOffset) {
+            fail("文件已损坏或被截断");
+        }
+
+        std::vector<size_t> dims(header.rank);
+        const char* base = static_cast<const char*>(mapping->base);
+        size_t total = 1;
+        for (size_t k = 0; k < header.rank; ++k) {
+            uint64_t d;
+            memcpy(&d, base + sizeof(header) + k * sizeof(uint64_t), sizeof(d));
+            dims[k] = static_cast<size_t>(d);
+            total *= dims[k];
+        }
+        if (total != header.count) fail("维度与元素数量不一致");
+
+        Variable out(VarType::ARRAY, "");
+        out.dims = dims;
+        out.strides = Variable::rowMajorStrides(dims);
+        out.store = std::make_shared<ArrayStore>();
+        if (header.dtype == ArrayFileHeader::FLOAT64) {
+            if (header.dataBytes != header.count * sizeof(double)) fail("数据区长度不正确");
+            mapping->offset = header.dataOffset;
+            mapping->count = header.count;
+            out.store->nums = NumBuffer(header.count, ZeroPageAllocator<double>(mapping));
+        } else if (shared) {
+            fail("只有数值数组可以以读写方式映射");
+        } else if (header.dtype == ArrayFileHeader::TEXT) {
+            out.store->numeric = false;
+            out.store->texts.reserve(header.count);
+            const char* p = base + header.dataOffset;
+            const char* end = p + header.dataBytes;
+            for (size_t i = 0; i < header.count; ++i) {
+                uint64_t n;
+                if (static_cast<size_t>(end - p) < sizeof(n)) fail("文件已损坏或被截断");
+                memcpy(&n, p, sizeof(n));
+                p += sizeof(n);
+                if (n > static_cast<uint64_t>(end - p)) fail("文件已损坏或被截断");
+                out.store->texts.emplace_back(p, static_cast<size_t>(n));
+                p += n;
             }
-            if (tokens[i].type == TokenType::OUTPUT_CONNECT) {
-                i++;
-                continue;
+        } else {
+            fail("未知的数据类型 " + std::to_string(header.dtype));
+        }
+        return out;
+    }
+
+    
+    Variable builtinMapfile(CallArgs& args) {
+        expectArgs(args, 2, SIZE_MAX);
+        std::string path = argText(args, 0);
+        std::string mode = argText(args, 1);
+        if (mode != "ro" && mode != "rw") {
+            const Token& at = args.tokens[args.ranges[1].first];
+            error(filename, at.line, at.col, "mapfile 的模式必须是 \"ro\" 或 \"rw\"");
+        }
+        if (args.size() > 2) {
+            if (mode != "rw") {
+                error(filename, args.callee.line, args.callee.col, "创建新的映射文件时模式必须是 \"rw\"");
             }
-            if (tokens[i].type == TokenType::STRING) {
-                outputContent += tokens[i].lexeme;
-                i++;
-            } else if (tokens[i].type == TokenType::DTIME_FUNC) {
-                if (!hasTocExecuted) {
-                    error(filename, tokens[i].line, tokens[i].col, 
-                          "dtime() 必须在 dtime_toc 之后使用");
-                }
-                outputContent += doubleToString(lastTocTime);
-                i++;
-            } else if (tokens[i].type == TokenType::IDENTIFIER) {
-                if (i + 1 < tokens.size() && tokens[i+1].type == TokenType::LBRACKET) {
-                    std::string arrayName = tokens[i].lexeme;
-                    i += 2;
-
-                    std::vector<size_t> indices;
-
-                    while (i < tokens.size() && tokens[i].type != TokenType::OUTLB && 
-                           tokens[i].type != TokenType::OUTPUT_CONNECT) {
-                        if (tokens[i].type == TokenType::LBRACKET) {
-                            i++;
-                            continue;
-                        }
+            std::vector<size_t> shape;
+            size_t total = 1;
+            for (size_t i = 2; i < args.size(); ++i) {
+                shape.push_back(sizeArg(args, i));
+                total *= shape.back();
+            }
+            writeArrayFile(args, path, shape, ArrayFileHeader::FLOAT64, nullptr, total * sizeof(double));
+        }
+        return mapArrayFile(args, path, mode == "rw");
+    }
 
-                        if (tokens[i].type == TokenType::RBRACKET) {
-                            i++;
-                            continue;
-                        }
+    
+    std::shared_ptr<FileMapping> mappedArg(CallArgs& args) {
+        Variable arr = argArray(args, 0);
+        auto mapping = arr.store->mapping();
+        if (!mapping) {
+            const Token& at = args.tokens[args.ranges[0].first];
+            error(filename, at.line, at.col,
+                  "函数 \'" + args.callee.lexeme + "\' 只能用于 load 或 mapfile 得到的文件映射数组");
+        }
+        return mapping;
+    }
 
-                        size_t exprEnd = i;
-                        while (exprEnd < tokens.size() && tokens[exprEnd].type != TokenType::RBRACKET) {
-                            exprEnd++;
-                        }
+    
+    Variable builtinAdvise(CallArgs& args) {
+        expectArgs(args, 2, 2);
+        auto mapping = mappedArg(args);
+        std::string hint = argText(args, 1);
+        int advice = 0;
+        if (hint == "normal") advice = MADV_NORMAL;
+        else if (hint == "sequential") advice = MADV_SEQUENTIAL;
+        else if (hint == "random") advice = MADV_RANDOM;
+        else if (hint == "willneed") advice = MADV_WILLNEED;
+        else if (hint == "dontneed") advice = MADV_DONTNEED;
+        else {
+            const Token& at = args.tokens[args.ranges[1].first];
+            error(filename, at.line, at.col, "未知的访问提示 \'" + hint + "\'，可选 normal、sequential、random、willneed、dontneed");
+        }
+        if (advice == MADV_DONTNEED && !mapping->shared) {
+            const Token& at = args.tokens[args.ranges[1].first];
+            error(filename, at.line, at.col, "dontneed 会丢弃只读映射上的修改，只能用于 \"rw\" 映射");
+        }
+        madvise(mapping->base, mapping->length, advice);
+        return Variable(VarType::INT, "0");
+    }
 
-                        if (exprEnd < tokens.size()) {
-                            std::vector<Token> indexExpr(tokens.begin() + i, tokens.begin() + exprEnd);
-                            size_t idx = 0;
-                            double indexValue = evaluateExpr(indexExpr, idx);
-                            indices.push_back(static_cast<size_t>(indexValue));
-                            i = exprEnd + 1;
-                        } else {
-                            break;
-                        }
-                    }
+    
+    Variable builtinSync(CallArgs& args) {
+        expectArgs(args, 1, 1);
+        auto mapping = mappedArg(args);
+        if (!mapping->shared) {
+            const Token& at = args.tokens[args.ranges[0].first];
+            error(filename, at.line, at.col, "sync 只能用于以 \"rw\" 模式映射的数组");
+        }
+        if (msync(mapping->base, mapping->length, MS_SYNC) != 0) {
+            error(filename, args.callee.line, args.callee.col, "同步映射文件 \'" + mapping->path + "\' 失败");
+        }
+        return Variable(VarType::INT, "0");
+    }
 
-                    auto it = vars.find(arrayName);
-                    if (it == vars.end()) {
-                        error(filename, tokens[i].line, tokens[i].col, "未声明的数组");
-                    }
+    
+    Variable builtinTojson(CallArgs& args) {
+        expectArgs(args, 1, 1);
+        std::string text;
+        StringSink sink{text};
+        if (!writeJson(sink, argValue(args, 0))) jsonTypeError(args);
+        return Variable(VarType::STRING, text);
+    }
 
-                    if (!it->second.dims.empty()) {
-                        if (indices.size() != it->second.dims.size()) {
-                            error(filename, tokens[i].line, tokens[i].col, "维度不匹配");
-                        }
-                        outputContent += it->second.getElement(indices).value;
-                    } else {
-                        outputContent += getArrayElement(arrayName, indices[0]);
-                    }
-                    continue;
-                } else {
-                    if (!hasVar(tokens[i].lexeme)) {
-                        error(filename, tokens[i].line, tokens[i].col,
-                              "变量 \'" + tokens[i].lexeme + "\' 未声明");
-                    }
-                    outputContent += getVar(tokens[i].lexeme);
-                    i++;
-                }
-            } else if (tokens[i].type == TokenType::NUMBER) {
-                outputContent += tokens[i].lexeme;
-                i++;
-            } else {
-                size_t exprEnd = i;
-                while (exprEnd < tokens.size() &&
-                       tokens[exprEnd].type != TokenType::OUTLB &&
-                       tokens[exprEnd].type != TokenType::OUTPUT_CONNECT) {
-                    exprEnd++;
-                }
-                if (exprEnd > i) {
-                    std::vector<Token> exprTokens(tokens.begin() + i, tokens.begin() + exprEnd);
-                    size_t idx = 0;
-                    try {
-                        double result = evaluateExpr(exprTokens, idx);
-                        outputContent += doubleToString(result);
-                    } catch (...) {
-                        error(filename, tokens[i].line, tokens[i].col, "输出表达式错误");
-                    }
-                    i = exprEnd;
-                } else {
-                    break;
-                }
-            }
+    
+    Variable builtinWritejson(CallArgs& args) {
+        expectArgs(args, 1, 1);
+        if (!writeJson(output(), argValue(args, 0))) jsonTypeError(args);
+        output().flushIfStale();
+        return Variable(VarType::INT, "0");
+    }
+
+    
+    void jsonTypeError(CallArgs& args) {
+        const Token& at = args.tokens[args.ranges[0].first];
+        error(filename, at.line, at.col, "只有数字、字符串、数组、字典和记录可以转换为 JSON");
+    }
+
+    
+    Variable parseJson(CallArgs& args, const char* first, const char* last, const std::string& source) {
+        JsonParser parser(first, last);
+        Variable out;
+        if (!parser.parseDocument(out)) {
+            error(filename, args.callee.line, args.callee.col, source + " 不是有效的 JSON: " + parser.problem);
         }
-        if (newline) {
-            std::cout << outputContent << std::endl;
-        } else {
-            std::cout << outputContent << std::flush;
+        return out;
+    }
+
+    
+    Variable builtinFromjson(CallArgs& args) {
+        expectArgs(args, 1, 1);
+        std::string text = argText(args, 0);
+        return parseJson(args, text.data(), text.data() + text.size(), "字符串");
+    }
+
+    
+    Variable builtinLoadjson(CallArgs& args) {
+        expectArgs(args, 1, 1);
+        std::string path = argText(args, 0);
+        int fd = ::open(path.c_str(), O_RDONLY);
+        struct stat st;
+        if (fd < 0 || fstat(fd, &st) != 0) {
+            if (fd >= 0) ::close(fd);
+            error(filename, args.callee.line, args.callee.col, "无法打开 JSON 文件 \'" + path + "\'");
         }
+        FileMapping mapping;
+        mapping.length = static_cast<size_t>(st.st_size);
+        if (mapping.length > 0) {
+            mapping.base = mmap(nullptr, mapping.length, PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+        ::close(fd);
+        if (mapping.base == MAP_FAILED) {
+            error(filename, args.callee.line, args.callee.col, "JSON 文件 \'" + path + "\' 为空或无法映射");
+        }
+        madvise(mapping.base, mapping.length, MADV_SEQUENTIAL);
+        const char* first = static_cast<const char*>(mapping.base);
+        return parseJson(args, first, first + mapping.length, "文件 \'" + path + "\'");
+    }
+
+    
+    Variable builtinFlush(CallArgs& args) {
+        expectArgs(args, 0, 0);
+        output().flush();
+        return Variable(VarType::INT, "0");
     }
 };
 
@@ -2466,6 +7849,7 @@ void check_update() {
 
 
 int main(int argc, char* argv[]) {
+    std::ios::sync_with_stdio(false);
     if (argc == 2) {
         if (strcmp(argv[1], "-v") == 0) {
             std::cout << "\033[1;35m创造无限可能！\033[0m" << std::endl;
@@ -2484,15 +7868,17 @@ int main(int argc, char* argv[]) {
         }
     }
 
-    if (argc != 2) {
-        std::cerr << "\033[1;33m用法: " << argv[0] << " <源文件.wei> | -v | -u\033[0m" << std::endl;
+    bool eachLine = argc == 3 && strcmp(argv[1], "--each-line") == 0;
+    if (argc != 2 && !eachLine) {
+        std::cerr << "\033[1;33m用法: " << argv[0] << " [--each-line] <源文件.wei> | -v | -u\033[0m" << std::endl;
         std::cerr << "  " << argv[0] << " -v       : 显示版本信息" << std::endl;
         std::cerr << "  " << argv[0] << " -u       : 检查更新" << std::endl;
         std::cerr << "  " << argv[0] << " program.wei : 编译并执行源文件" << std::endl;
+        std::cerr << "  " << argv[0] << " --each-line program.wei : 先执行 main，再对标准输入的每一行执行 each 函数，最后执行 teardown 函数" << std::endl;
         return 1;
     }
 
-    std::string filename = argv[1];
+    std::string filename = argv[eachLine ? 2 : 1];
 
     struct stat buffer;
     if (stat(filename.c_str(), &buffer) != 0) {
@@ -2602,6 +7988,20 @@ int main(int argc, char* argv[]) {
         }
     }
 
+    const std::vector<Token>* eachBody = nullptr;
+    const std::vector<Token>* teardownBody = nullptr;
+    if (eachLine) {
+        auto each = interp.functions.find("each");
+        if (each == interp.functions.end()) {
+            error(filename, 0, 0, "--each-line 模式需要定义逐行处理函数: create each(function).falid { ... }");
+        }
+        eachBody = &each->second.body;
+        auto teardown = interp.functions.find("teardown");
+        if (teardown != interp.functions.end()) teardownBody = &teardown->second.body;
+    }
+
     interp.execute(mainBody);
+    if (eachBody) interp.streamRecords(*eachBody, teardownBody);
+    output().flush();
     return 0;
 }